@@ -0,0 +1,17 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "magic.h"
+#include "zobrist.h"
+#include <stdint.h>
+
+#define BENCH_DEFAULT_DEPTH 7
+#define BENCH_DEFAULT_THREADS 1
+#define BENCH_DEFAULT_HASH_MB 16
+
+// Searches the built-in positions to a fixed depth from a cleared transposition table and prints
+// the total nodes, time and nps. With one thread the node count is deterministic and serves as a
+// signature of the search: it only changes when the search itself does. Returns the node count.
+uint64_t run_bench(int depth, int threads, int hash_mb, const MagicData* magic, const ZobristKeys* keys);
+
+#endif
@@ -7,16 +7,17 @@
 
 #define ON_BOARD(sq) ((sq) >= 0 && (sq) < 64)
 
-#define RANK(sq) (sq / 8)
-#define FILE(sq) (sq % 8)
+#define RANK(sq) ((sq) / 8)
+#define FILE(sq) ((sq) % 8)
 
-#define RANK_X(rank_num) (0x00000000000000FFULL << (rank_num * 8))
-#define FILE_X(file_num) (0x0101010101010101ULL << file_num)
+#define RANK_X(rank_num) (0x00000000000000FFULL << ((rank_num) * 8))
+#define FILE_X(file_num) (0x0101010101010101ULL << (file_num))
 
-#define MIRROR(sq) (sq ^ 56)
+#define MIRROR(sq) ((sq) ^ 56)
 
-#define SQUARES_AHEAD(sq, side) (side == WHITE) ? ~((1ULL << ((RANK(sq) + 1) * 8)) - 1) : ((1ULL << (RANK(sq) * 8)) - 1)
-#define SQUARES_BEHIND(sq, side) (side == WHITE) ? ((1ULL << (RANK(sq) * 8)) - 1) : ~((1ULL << ((RANK(sq) + 1) * 8)) - 1)
+// 2ULL << (rank * 8 + 7) is the first square of the next rank, and 0 past the eighth rank instead of a 64-bit shift
+#define SQUARES_AHEAD(sq, side) (((side) == WHITE) ? ~((2ULL << (RANK(sq) * 8 + 7)) - 1) : ((1ULL << (RANK(sq) * 8)) - 1))
+#define SQUARES_BEHIND(sq, side) (((side) == WHITE) ? ((1ULL << (RANK(sq) * 8)) - 1) : ~((2ULL << (RANK(sq) * 8 + 7)) - 1))
 
 typedef uint64_t Bitboard;
 typedef uint64_t File;
@@ -25,6 +26,7 @@ typedef uint64_t Rank;
 typedef struct {
     Bitboard pieces[12]; // 0-5: white P, N, B, R, Q, K | 6-11: black P, N, B, R, Q, K
     Bitboard occupied[3]; // 0: white, 1: black, 2: all pieces
+    int8_t mailbox[64]; // piece on each square (same indices as pieces[]), -1 if empty
     int side_to_move; // 0 for white, 1 for black
     int castling_rights; // 4 bits: WK = 1, WQ = 2, BK = 4, BQ = 8
     int king_from[2]; // Index 0 = white king square, 1 = black
@@ -36,6 +38,10 @@ typedef struct {
     int fullmove_number; // number of full moves (starts at 1)
     bool has_castled;
     uint64_t zobrist_hash;
+    uint64_t pawn_hash; // Zobrist key of the pawns alone, for the pawn structure cache
+    int psq_mg; // Material + PST sums from white's point of view, kept up to date by make_move()
+    int psq_eg;
+    int phase;  // Game phase from the remaining pieces (N, B = 1, R = 2, Q = 4), not capped
 } Position;
 
 typedef enum {
@@ -94,8 +100,6 @@ typedef enum {
 } MoveFlags;
 
 void init_position(Position* pos, const char* fen);
-Bitboard squares_between_inclusive(int a, int b);
-Bitboard squares_between_exclusive(int a, int b);
 void print_board(const Position* pos);
 void print_bitboard(Bitboard bb);
 void print_position(const Position* pos);
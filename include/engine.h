@@ -5,6 +5,6 @@
 #include "tt.h"
 #include "zobrist.h"
 
-void init_engine(MagicData* magic, ZobristKeys* keys);
+void init_engine(void);
 
 #endif
\ No newline at end of file
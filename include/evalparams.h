@@ -128,7 +128,18 @@ typedef struct {
     double king_zone_attacker_eg[6][9];
 } EvalParamsDouble;
 
+// Material + PST of every piece on every square from white's point of view, built from the
+// evaluation parameters so that make_move() can update the sums incrementally. find_best_move()
+// rebuilds them through use_psq_tables() when it is given other material or PST values.
+extern int psq_mg[12][64];
+extern int psq_eg[12][64];
+extern const int phase_weight[6];
+
 void set_default_evalparams(EvalParams* p);
+void init_psq_tables(const EvalParams* p);
+int use_psq_tables(const EvalParams* p);
+void compute_psq_state(const Position* pos, int* mg, int* eg, int* phase);
+void refresh_psq_state(Position* pos);
 void init_double_params(EvalParamsDouble* d);
 
 #endif
\ No newline at end of file
@@ -4,15 +4,27 @@
 #include "board.h"
 #include "evalparams.h"
 #include "movegen.h"
+#include "pawnhash.h"
+#include "timeman.h"
 #include "magic.h"
+#include <pthread.h>
+#include <stdatomic.h>
 
 #define MATE_SCORE 100000
 #define DRAW_SCORE 0
 
 #define MAX_PLY 64  // Max search depth you expect
-extern int killer_moves[MAX_PLY][2];  // Two killer moves per ply
+#define MAX_REP_HISTORY 1024
+#define MAX_GAME_HISTORY (MAX_REP_HISTORY - MAX_PLY - 1) // Leaves room for the root and the search path
+#define MAX_THREADS 256
+#define EVAL_CACHE_SIZE 8192 // Entries, must be a power of two
 
-extern int history_table[64][64];
+// Static evaluation of one position, side to move's point of view
+typedef struct {
+    uint64_t key;
+    int score;
+    int valid;
+} EvalCacheEntry;
 
 extern int piece_values[];
 
@@ -23,21 +35,100 @@ extern const int
     rook_pst_mg[64], rook_pst_eg[64],
     queen_pst_mg[64], queen_pst_eg[64],
     king_pst_mg[64], king_pst_eg[64];
-    
-// External arrays
-extern int killer_moves[MAX_PLY][2];
-extern int history_table[64][64];
-extern int counter_moves[64][64];
-
-void sort_moves(Position* pos, MoveList* list, int ply, int tt_move, const MagicData* magic);
-int move_order_heuristic(const Position* pos, int move, int ply);
+
+#ifdef SEARCH_STATS
+// Search event counters, only compiled in with SEARCH_STATS (make STATS=yes)
+typedef struct {
+    uint64_t qnodes;
+    uint64_t tt_probes;
+    uint64_t tt_hits;          // Entry found, whether or not it was deep enough
+    uint64_t tt_cutoffs;
+    uint64_t fail_highs;
+    uint64_t first_move_fail_highs;
+    uint64_t null_tries;
+    uint64_t null_cutoffs;
+    uint64_t razor_cutoffs;
+    uint64_t reverse_futility_cutoffs;
+    uint64_t futility_pruned;  // Quiet moves skipped
+    uint64_t lmr_searches;
+    uint64_t lmr_researches;   // Reduced searches that beat alpha and were repeated at full depth
+    uint64_t aspiration_fail_lows;  // Root re-searches with a widened window
+    uint64_t aspiration_fail_highs;
+} SearchStats;
+
+#define STATS_INC(td, counter) ((td)->stats.counter++)
+#else
+#define STATS_INC(td, counter) ((void)0)
+#endif
+
+// Keys of the positions played in the game before the one being searched, oldest first. Only
+// positions since the last irreversible move matter, since no earlier one can occur again.
+typedef struct {
+    uint64_t keys[MAX_GAME_HISTORY];
+    int count;
+} GameHistory;
+
+// Per-thread search state: every Lazy SMP worker owns its own position, search stack and
+// move ordering heuristics, while the transposition table is shared between all of them
+typedef struct {
+    int id; // 0 = main thread, the others are helpers
+    Position pos;
+
+    int killer_moves[MAX_PLY][2];  // Two killer moves per ply
+    int history_table[64][64];
+    int counter_moves[64][64];     // Quiet reply that refuted the previous move, by its from/to squares
+    int move_stack[MAX_PLY];       // Move made at each ply of the current line, 0 for a null move
+
+    // Triangular PV table: row ply holds the best line found so far from that ply on
+    int pv_table[MAX_PLY][MAX_PLY];
+    int pv_length[MAX_PLY];
+    int best_pv[MAX_PLY];          // Principal variation of the last completed iteration
+    int best_pv_length;
+
+    PawnTable pawn_table;
+    EvalCacheEntry eval_cache[EVAL_CACHE_SIZE]; // Direct-mapped on the zobrist hash
+
+    // Keys of the game history, the root and the current search path, up to the current node's parent
+    uint64_t repetition_table[MAX_REP_HISTORY];
+    int repetition_index;
+
+    int max_depth;
+    int completed_depth; // Deepest fully searched iteration
+    int best_move;
+    int best_score;
+    _Atomic uint64_t nodes; // Only written by the owning thread, read by the main thread for info output
+#ifdef SEARCH_STATS
+    SearchStats stats;
+#endif
+
+    const EvalParams* params;
+    const MagicData* magic;
+    const ZobristKeys* keys;
+    const TimeManager* time; // NULL when the search is only bounded by depth
+    pthread_t handle;
+} SearchThread;
+
+// Set when the main thread finishes so that the helpers abandon their current iteration
+extern atomic_int search_stopped;
+// Set from outside the search (UCI stop or quit); polled by the main search thread
+extern atomic_int stop_requested;
+// Set while the search runs on the opponent's time: the clock is ignored until ponderhit clears it
+extern atomic_int search_pondering;
+
+void set_search_threads(int count);
+int get_search_threads(void);
+uint64_t get_search_nodes(void);
+int get_search_score(void);
+
+int move_order_heuristic(const SearchThread* td, const Position* pos, int move, int ply);
 int see(const Position* pos, int move, const MagicData* magic);
-int quiescence(Position* pos, int alpha, int beta, const EvalParams* params, const MagicData* magic, ZobristKeys* keys);
-int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_node, const EvalParams* params, const MagicData* magic, ZobristKeys* keys);
-int find_best_move(Position* pos, int max_depth, const EvalParams* params,
-                   const MagicData* magic, ZobristKeys* keys,
-                   int* mate_line, int* mate_length);
-int score_move(const Position* pos, int move, int ply, int tt_move, const MagicData* magic);
+int quiescence(SearchThread* td, Position* pos, int alpha, int beta, const EvalParams* params, const MagicData* magic, const ZobristKeys* keys);
+int search(SearchThread* td, Position* pos, int depth, int ply, int alpha, int beta, int is_pv_node, const EvalParams* params, const MagicData* magic, const ZobristKeys* keys);
+// Returns the best move (0 without a legal move). history may be NULL when the game before pos is
+// unknown. pv_line, if given, receives the principal variation and must hold MAX_PLY moves.
+int find_best_move(Position* pos, int max_depth, const TimeManager* time, const GameHistory* history, const EvalParams* params,
+                   const MagicData* magic, const ZobristKeys* keys,
+                   int* pv_line, int* pv_length);
 int get_lmr_reduction(int depth, int move_count, int is_pv, int is_capture, int gives_check);
 
-#endif
\ No newline at end of file
+#endif
@@ -4,12 +4,12 @@
 #include "board.h"
 #include "evalparams.h"
 #include "evaltuner.h"
+#include "geometry.h"
 #include "magic.h"
+#include "pawnhash.h"
 
 static inline int manhattan(int sq1, int sq2) {
-    int f1 = sq1 % 8, r1 = sq1 / 8;
-    int f2 = sq2 % 8, r2 = sq2 / 8;
-    return abs(f1 - f2) + abs(r1 - r2);
+    return manhattan_table[sq1][sq2];
 }
 
 void evaluate_passed_pawns(const Position* pos, FeatureCounts* counts, const EvalParams* params, const EvalParamsDouble* dparams, int side, int* mg, int* eg, double* dmg, double* deg);
@@ -17,6 +17,6 @@ void evaluate_knight_outposts(const Position* pos, FeatureCounts* counts, const
 void evaluate_rook_activity(const Position* pos, FeatureCounts* counts, const EvalParams* params, const EvalParamsDouble* dparams, int side, int* mg, int* eg, double* dmg, double* deg);
 void evaluate_king_safety(const Position* pos, const MagicData* magic, FeatureCounts* counts, const EvalParams* params, const EvalParamsDouble* dparams, int side, int* mg, int* eg, double* dmg, double* deg);
 void evaluate_tropism(const Position* pos, FeatureCounts* counts, const EvalParams* params, const EvalParamsDouble* dparams, int side, int* mg, int* eg, double* dmg, double* deg);
-int evaluation(const Position* pos, const EvalParams* params, const MagicData* magic);
+int evaluation(const Position* pos, const EvalParams* params, const MagicData* magic, PawnTable* pawn_table);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include "board.h"
+#include <stdint.h>
+
+// Board geometry that only depends on the squares involved, filled once by init_geometry() so the
+// hot paths (move generation, attack tests, SEE, king safety) never loop over rays or do div/mod
+extern Bitboard knight_attack_table[64];
+extern Bitboard king_attack_table[64];
+extern Bitboard pawn_attack_table[2][64]; // Squares a pawn of the given side attacks from each square
+extern Bitboard between_table[64][64];    // Squares strictly between two aligned squares, 0 otherwise
+extern Bitboard line_table[64][64];       // Whole board line through two aligned squares, 0 otherwise
+extern uint8_t manhattan_table[64][64];
+
+void init_geometry(void);
+
+static inline Bitboard squares_between_exclusive(int a, int b) {
+    return between_table[a][b];
+}
+
+// Same as above with both end points, or just the square itself when a == b
+static inline Bitboard squares_between_inclusive(int a, int b) {
+    if (a == b) return 1ULL << a;
+    if (!line_table[a][b]) return 0;
+    return between_table[a][b] | (1ULL << a) | (1ULL << b);
+}
+
+// True when the three squares lie on one rank, file or diagonal
+static inline int squares_aligned(int a, int b, int c) {
+    return (line_table[a][b] & (1ULL << c)) != 0;
+}
+
+#endif
@@ -4,10 +4,22 @@
 #include "board.h"
 #include <stdint.h>
 
+// Slider attacks are indexed with PEXT when the compiler targets BMI2, otherwise with the
+// multiply-shift magics. Build with PEXT=no to keep the magics on CPUs where PEXT is microcoded
+// (AMD before Zen 3), since it is far slower than the multiply there.
+#if defined(__BMI2__) && !defined(NO_PEXT)
+#define USE_PEXT
+#include <immintrin.h>
+#endif
+
 #define MAX_ROOK_MOVES 4096
 #define MAX_BISHOP_MOVES 512
 #define MAX_BLOCKER_VARIATIONS 4096
 
+// Sum of 1 << shift over all squares, the size of the packed attack tables (about 840 KB together)
+#define ROOK_TABLE_ENTRIES 102400
+#define BISHOP_TABLE_ENTRIES 5248
+
 extern const Bitboard rook_magics_const[64];
 extern const Bitboard bishop_magics_const[64];
 extern const int rook_shifts_const[64];
@@ -20,8 +32,17 @@ typedef struct {
     uint32_t bishop_shifts[64];
     Bitboard rook_masks[64];
     Bitboard bishop_masks[64];
-    Bitboard rook_attack_table[64][MAX_ROOK_MOVES];
-    Bitboard bishop_attack_table[64][MAX_BISHOP_MOVES];
+
+    // "Fancy" magics: the attacks of each square are packed back to back from its offset, with
+    // 1 << shift slots each instead of a fixed worst case row per square
+    uint32_t rook_offsets[64];
+    uint32_t bishop_offsets[64];
+    Bitboard rook_attack_table[ROOK_TABLE_ENTRIES];
+    Bitboard bishop_attack_table[BISHOP_TABLE_ENTRIES];
+
+    // PEXT tables with the same offsets, indexed by the blockers on the mask extracted into the low bits
+    Bitboard rook_pext_table[ROOK_TABLE_ENTRIES];
+    Bitboard bishop_pext_table[BISHOP_TABLE_ENTRIES];
 } MagicData;
 
 static const int rook_deltas[4]   = {8, -8, 1, -1};
@@ -49,6 +70,20 @@ static inline Bitboard set_blockers_from_index(uint64_t index, Bitboard mask) {
     return blockers;
 }
 
+// Gather the bits of x selected by mask into the low bits, the inverse of set_blockers_from_index()
+static inline uint64_t pext_u64(uint64_t x, uint64_t mask) {
+#ifdef USE_PEXT
+    return _pext_u64(x, mask);
+#else
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (x & mask & -mask) result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+#endif
+}
+
 // Compute blocker mask for bishops
 static inline Bitboard mask_bishop_blockers(int sq) {
     Bitboard mask = 0ULL;
@@ -114,9 +149,10 @@ static inline Bitboard compute_rook_attacks(int sq, Bitboard blockers) {
     return attacks;
 }
 
-void init_magic(MagicData* magic);
+// Every table, generated at build time by tools/gen_magic_tables.c into read-only data
+extern const MagicData magic_data;
 
-int save_magic_tables(const MagicData* magic, const char* path);
-int load_magic_tables(MagicData* magic, const char* path);
+// Computes the tables from scratch, for the generator and the self test
+void build_magic_tables(MagicData* magic);
 
 #endif
\ No newline at end of file
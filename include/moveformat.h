@@ -7,6 +7,6 @@
 int encode_move(int from_sq, int to_sq, int move_flag);
 void square_to_coords(int sq, char* buf);
 void move_to_string(int move);
-void move_to_san(const Position* pos, int move, char* san, const MagicData* magic, ZobristKeys* keys);
+void move_to_san(const Position* pos, int move, char* san, const MagicData* magic, const ZobristKeys* keys);
 
 #endif
\ No newline at end of file
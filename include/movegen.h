@@ -2,6 +2,7 @@
 #define MOVEGEN_H
 
 #include "board.h"
+#include "geometry.h"
 #include "magic.h"
 #include "moveformat.h"
 #include "operations.h"
@@ -10,7 +11,7 @@
 #include <string.h>
 
 #define BOARD_SIZE 64
-#define MAX_MOVES 1024
+#define MAX_MOVES 256 // No legal chess position has more than 218 moves
 
 #define MOVE_FROM(move) ((move >> 6) & 0x3F)
 #define MOVE_TO(move) (move & 0x3F)
@@ -34,6 +35,28 @@ typedef struct {
     int count;
 } MoveList;
 
+// Which moves a generator emits. Noisy moves are captures (including en passant and capturing
+// promotions) and queen promotions; everything else, underpromotions and castling included, is quiet.
+typedef enum {
+    GEN_ALL,
+    GEN_NOISY,
+    GEN_QUIET
+} GenType;
+
+// True for the moves GEN_NOISY emits
+static inline int move_is_noisy(int move) {
+    int flag = MOVE_FLAG(move);
+    return flag == CAPTURE || flag == EN_PASSANT || flag == PROMOTE_Q || flag >= PROMOTE_N_CAPTURE;
+}
+
+// Checkers and pinned pieces of the side to move, computed once per node for the legality test
+typedef struct {
+    int king_sq;
+    Bitboard checkers;   // Enemy pieces giving check
+    Bitboard pinned;     // Own pieces pinned against the king
+    Bitboard check_mask; // Squares a non-king move must land on (every square when not in check)
+} LegalityInfo;
+
 typedef struct {
     int from;
     int to;
@@ -49,62 +72,72 @@ typedef struct {
     int fullmove_number;
     int rook_from_before[4];
     bool has_castled;
+    uint64_t zobrist_hash; // Hash keys before the move, restored as a whole by unmake_move()
+    uint64_t pawn_hash;
+    int psq_mg; // Evaluation accumulators before the move
+    int psq_eg;
+    int phase;
 } MoveState;
 
 /* ---------- General helper functions ---------- */
 
-// Function to get the piece on a given square
+// Function to get the piece on a given square (-1 if the square is empty)
 static inline int get_piece_on_square(const Position* pos, int sq) {
-    // Initialize a bitboard with a bit set at the given square to compare with all piece bitboards 
-    Bitboard piece_bb = 1ULL << sq;
-    // For every piece bitboard, check if there is a piece on the same square as the previously set bitboard and return the piece if one is found
-    for (int piece = 0; piece < 12; piece++) {
-        if (pos->pieces[piece] & piece_bb) return piece;
-    }
-
-    // Return -1 if no piece is found
-    return -1;
+    // The mailbox is kept in sync with the piece bitboards by make_move() and unmake_move()
+    return pos->mailbox[sq];
 }
-void print_moves(const Position* pos, const MoveList* list, const MagicData* magic, ZobristKeys* keys);
+void print_moves(const Position* pos, const MoveList* list, const MagicData* magic, const ZobristKeys* keys);
 
 /* ---------- Attack lookup functions ---------- */
 
 // Function to generate knight attacks
 static inline Bitboard knight_attacks(int sq) {
+    return knight_attack_table[sq];
+}
 
-    // Initialize the knight bitboard
-    Bitboard knight = 0;
-    // Set the knight to be on the given square
-    set_bit(knight, sq);
-    
-    // Precompute knight moves with file masks to prevent wrap-around (overflow automatically handled by bitwise operations)
-    Bitboard precomputed_knight_attacks = 0;
-
-    precomputed_knight_attacks |= (knight & ~FILE_X(7)) << 17; // +1 file, +2 ranks
-    precomputed_knight_attacks |= (knight & ~FILE_X(0)) << 15; // -1 file, +2 ranks
-    precomputed_knight_attacks |= (knight & ~(FILE_X(7) | FILE_X(6))) << 10; // +2 files, +1 rank
-    precomputed_knight_attacks |= (knight & ~(FILE_X(0) | FILE_X(1))) << 6; // -2 files, +1 rank
-    precomputed_knight_attacks |= (knight & ~FILE_X(0)) >> 17; // -1 file, -2 ranks
-    precomputed_knight_attacks |= (knight & ~FILE_X(7)) >> 15; // +1 file, -2 ranks
-    precomputed_knight_attacks |= (knight & ~(FILE_X(0) | FILE_X(1))) >> 10; // -2 files, -1 rank
-    precomputed_knight_attacks |= (knight & ~(FILE_X(7) | FILE_X(6))) >> 6; // +2 files, -1 rank
-
-    // Return the precomputed knight moves
-    return precomputed_knight_attacks;
+// Squares attacked by a pawn of the given side standing on sq
+static inline Bitboard pawn_attacks(int sq, int side) {
+    return pawn_attack_table[side][sq];
 }
 
-// Function to generate bishop attacks
-static inline Bitboard bishop_attacks(int sq, Bitboard occupancy, const MagicData* magic) {
+// Slider attacks through the multiply-shift magics
+static inline Bitboard bishop_attacks_magic(int sq, Bitboard occupancy, const MagicData* magic) {
     Bitboard blockers = occupancy & magic->bishop_masks[sq];
     uint64_t index = (blockers * magic->bishop_magics[sq]) >> (64 - magic->bishop_shifts[sq]);
-    return magic->bishop_attack_table[sq][index];
+    return magic->bishop_attack_table[magic->bishop_offsets[sq] + index];
 }
 
-// Function to generate rook attacks
-static inline Bitboard rook_attacks(int sq, Bitboard occupancy, const MagicData* magic) {
+static inline Bitboard rook_attacks_magic(int sq, Bitboard occupancy, const MagicData* magic) {
     Bitboard blockers = occupancy & magic->rook_masks[sq];
     uint64_t index = (blockers * magic->rook_magics[sq]) >> (64 - magic->rook_shifts[sq]);
-    return magic->rook_attack_table[sq][index];
+    return magic->rook_attack_table[magic->rook_offsets[sq] + index];
+}
+
+// Slider attacks through the packed PEXT tables (a slow software PEXT without BMI2, for the self test)
+static inline Bitboard bishop_attacks_pext(int sq, Bitboard occupancy, const MagicData* magic) {
+    return magic->bishop_pext_table[magic->bishop_offsets[sq] + pext_u64(occupancy, magic->bishop_masks[sq])];
+}
+
+static inline Bitboard rook_attacks_pext(int sq, Bitboard occupancy, const MagicData* magic) {
+    return magic->rook_pext_table[magic->rook_offsets[sq] + pext_u64(occupancy, magic->rook_masks[sq])];
+}
+
+// Function to generate bishop attacks
+static inline Bitboard bishop_attacks(int sq, Bitboard occupancy, const MagicData* magic) {
+#ifdef USE_PEXT
+    return bishop_attacks_pext(sq, occupancy, magic);
+#else
+    return bishop_attacks_magic(sq, occupancy, magic);
+#endif
+}
+
+// Function to generate rook attacks
+static inline Bitboard rook_attacks(int sq, Bitboard occupancy, const MagicData* magic) {
+#ifdef USE_PEXT
+    return rook_attacks_pext(sq, occupancy, magic);
+#else
+    return rook_attacks_magic(sq, occupancy, magic);
+#endif
 }
 
 // Function to generate queen attacks
@@ -114,26 +147,7 @@ static inline Bitboard queen_attacks(int sq, Bitboard occupancy, const MagicData
 
 // Function to generate king attacks
 static inline Bitboard king_attacks(int sq) {
-
-    // Initialize the king bitboard
-    Bitboard king = 0;
-    // Set the king to be on the given square
-    set_bit(king, sq);
-
-    // Precompute king moves with file masks to prevent wrap-around (overflow automatically handled by bitwise operations)
-    Bitboard precomputed_king_attacks = 0;
-
-    precomputed_king_attacks |= (king & ~FILE_X(0)) << 7; // -1 file, +1 rank
-    precomputed_king_attacks |= king << 8; // +1 rank
-    precomputed_king_attacks |= (king & ~FILE_X(7)) << 9; // +1 file, +1 rank
-    precomputed_king_attacks |= (king & ~FILE_X(7)) << 1; // +1 file
-    precomputed_king_attacks |= (king & ~FILE_X(7)) >> 7; // +1 file, -1 rank
-    precomputed_king_attacks |= king >> 8; // -1 rank
-    precomputed_king_attacks |= (king & ~FILE_X(0)) >> 9; // -1 file, -1 rank
-    precomputed_king_attacks |= (king & ~FILE_X(0)) >> 1; // -1 file
-    
-    // Return the precomputed king moves
-    return precomputed_king_attacks;
+    return king_attack_table[sq];
 }
 
 // Is a given square attacked by a given side?
@@ -146,11 +160,8 @@ static inline int is_square_attacked(const Position* pos, int sq, int attacking_
 
     // Initialize the pawn bitboard for the attacking side
     Bitboard pawns = pos->pieces[attacking_side == WHITE ? WP : BP];
-    // Initialize a bitboard for all pawn attacks from the given square
-    Bitboard pawn_attackers = (attacking_side == WHITE)
-        ? (((1ULL << sq) & ~FILE_X(7)) >> 7) | (((1ULL << sq) & ~FILE_X(0)) >> 9)
-        : (((1ULL << sq) & ~FILE_X(0)) << 7) | (((1ULL << sq) & ~FILE_X(7)) << 9);
-
+    // The attacking pawns stand where a pawn of the other colour on the square would attack
+    Bitboard pawn_attackers = pawn_attacks(sq, attacking_side ^ 1);
 
     if (pawns & pawn_attackers) return 1;
 
@@ -198,23 +209,11 @@ static inline Bitboard get_attackers_to(const Position* pos, int sq, Bitboard oc
     if (!pos || sq < 0 || sq >= 64) return 0ULL;
 
     Bitboard attackers = 0ULL;
-    Bitboard sq_bb = 1ULL << sq;
 
     /* ---------- Pawn attackers ---------- */
-    if (sq >= 0 && sq < 64) {
-        // White pawns attack like black
-        Bitboard white_pawn_attackers =
-            ((sq_bb & ~FILE_X(7)) >> 7) |
-            ((sq_bb & ~FILE_X(0)) >> 9);
-
-        // Black pawns attack like white
-        Bitboard black_pawn_attackers =
-            ((sq_bb & ~FILE_X(0)) << 7) |
-            ((sq_bb & ~FILE_X(7)) << 9);
-
-        attackers |= pos->pieces[WP] & white_pawn_attackers;
-        attackers |= pos->pieces[BP] & black_pawn_attackers;
-    }
+    // White pawns attack the square from where a black pawn on it would attack, and vice versa
+    attackers |= pos->pieces[WP] & pawn_attacks(sq, BLACK);
+    attackers |= pos->pieces[BP] & pawn_attacks(sq, WHITE);
 
     /* ---------- Knight attackers ---------- */
     Bitboard knight_mask = knight_attacks(sq);
@@ -243,8 +242,15 @@ static inline Bitboard get_attackers_to(const Position* pos, int sq, Bitboard oc
 
 /* ---------- Individual piece move generation functions ---------- */ 
 
+// Destination squares for piece moves of the given generation type
+static inline Bitboard generation_targets(const Position* pos, int side, GenType type) {
+    if (type == GEN_NOISY) return pos->occupied[side ^ 1];
+    if (type == GEN_QUIET) return ~pos->occupied[ALL];
+    return ~pos->occupied[side];
+}
+
 // Function to generate moves for all pawns on the bitboard
-static inline void generate_pawn_moves(const Position* pos, MoveList* list, int side) {
+static inline void generate_pawn_moves(const Position* pos, MoveList* list, int side, GenType type) {
     if (!pos || !list) return;
     // Get the pawn bitboard for the current side
     Bitboard pawns = pos->pieces[side == WHITE ? WP : BP];
@@ -266,7 +272,7 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
     /* ---------- Single pushes (non-promoting) ---------- */
     
     // Single push every pawn on the bitboard if the square in front is empty and is not on the promotion rank
-    Bitboard non_promo_single_pushes = (side == WHITE)
+    Bitboard non_promo_single_pushes = (type == GEN_NOISY) ? 0 : (side == WHITE)
         ? (pawns << 8) & empty & ~promotion_rank
         : (pawns >> 8) & empty & ~promotion_rank;
     
@@ -283,7 +289,7 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
     /* ---------- Double pushes (non-promoting) ---------- */
 
     // Double push every pawn on the bitboard if the pawn is on the 2nd (white) or 7th (black) rank and both of the two squares in front are empty
-    Bitboard double_pushes = (side == WHITE)
+    Bitboard double_pushes = (type == GEN_NOISY) ? 0 : (side == WHITE)
         ? ((((pawns & RANK_X(1)) << 8) & empty) << 8) & empty
         : ((((pawns & RANK_X(6)) >> 8) & empty) >> 8) & empty;
     
@@ -300,7 +306,7 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
     /* ---------- Captures (left, non-promoting) ---------- */
 
     // Compute left captures for every pawn on the bitboard if the square diagonally left is occupied by an opponent's piece, is not the enemy king, and is not on the promotion rank
-    Bitboard non_promo_left_captures = (side == WHITE)
+    Bitboard non_promo_left_captures = (type == GEN_QUIET) ? 0 : (side == WHITE)
         ? (pawns & ~FILE_X(0)) << 7 & opp & ~enemy_king & ~promotion_rank
         : (pawns & ~FILE_X(0)) >> 9 & opp & ~enemy_king & ~promotion_rank;
     
@@ -317,7 +323,7 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
     /* ---------- Captures (right, non-promoting) ---------- */
 
     // Compute right captures for every pawn on the bitboard if the square diagonally right is occupied by an opponent's piece, is not the enemy king, and is not on the promotion rank
-    Bitboard non_promo_right_captures = (side == WHITE)
+    Bitboard non_promo_right_captures = (type == GEN_QUIET) ? 0 : (side == WHITE)
         ? (pawns & ~FILE_X(7)) << 9 & opp & ~enemy_king & ~promotion_rank
         : (pawns & ~FILE_X(7)) >> 7 & opp & ~enemy_king & ~promotion_rank;
     
@@ -344,17 +350,21 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
         int to = pop_lsb(&push_promotions);
         // Compute the square from which the pawn pushed from
         int from = to - forward;
-        // Add the moves to the list
-        SAFE_ADD_MOVE(list, from, to, PROMOTE_N);
-        SAFE_ADD_MOVE(list, from, to, PROMOTE_B);
-        SAFE_ADD_MOVE(list, from, to, PROMOTE_R);
-        SAFE_ADD_MOVE(list, from, to, PROMOTE_Q);
+        // Add the moves to the list: the queen promotion is noisy, underpromotions are quiet
+        if (type != GEN_NOISY) {
+            SAFE_ADD_MOVE(list, from, to, PROMOTE_N);
+            SAFE_ADD_MOVE(list, from, to, PROMOTE_B);
+            SAFE_ADD_MOVE(list, from, to, PROMOTE_R);
+        }
+        if (type != GEN_QUIET) {
+            SAFE_ADD_MOVE(list, from, to, PROMOTE_Q);
+        }
     }
 
     /* ---------- Promotions (left-capturing) ---------- */
 
     // Compute left capture promotions for every pawn on the bitboard if the square diagonally left is occupied by an opponent's piece, is not the enemy king, and is on the promotion rank
-    Bitboard left_cap_promotions = (side == WHITE)
+    Bitboard left_cap_promotions = (type == GEN_QUIET) ? 0 : (side == WHITE)
         ? (pawns & ~FILE_X(0)) << 7 & opp & ~enemy_king & promotion_rank
         : (pawns & ~FILE_X(0)) >> 9 & opp & ~enemy_king & promotion_rank;
     
@@ -374,7 +384,7 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
     /* ---------- Promotions (right-capturing) ---------- */
 
     // Compute right capture promotions for every pawn on the bitboard if the square diagonally right is occupied by an opponent's piece, is not the enemy king, and is on the promotion rank
-    Bitboard right_cap_promotions = (side == WHITE)
+    Bitboard right_cap_promotions = (type == GEN_QUIET) ? 0 : (side == WHITE)
         ? (pawns & ~FILE_X(7)) << 9 & opp & ~enemy_king & promotion_rank
         : (pawns & ~FILE_X(7)) >> 7 & opp & ~enemy_king & promotion_rank;
     
@@ -394,7 +404,7 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
     /* ---------- En passant ---------- */
 
     // Check if en passant is available
-    if (pos->en_passant != -1) {
+    if (pos->en_passant != -1 && type != GEN_QUIET) {
         // Get the en passant square as a bitboard
         Bitboard ep_square = 1ULL << pos->en_passant;
 
@@ -425,12 +435,10 @@ static inline void generate_pawn_moves(const Position* pos, MoveList* list, int
 }
 
 // Function to generate moves for all knights on the bitboard
-static inline void generate_knight_moves(const Position* pos, MoveList* list, int side) {
+static inline void generate_knight_moves(const Position* pos, MoveList* list, int side, GenType type) {
     if (!pos || !list) return;
     // Get the knight bitboard for the current side
     Bitboard knights = pos->pieces[side == WHITE ? WN : BN];
-    // Get the occupied squares for the current side
-    Bitboard own = pos->occupied[side];
     // Get the occupied squares for the opponent
     Bitboard opp = pos->occupied[side ^ 1];
     // Get the enemy king bitboard
@@ -447,7 +455,7 @@ static inline void generate_knight_moves(const Position* pos, MoveList* list, in
         }
 
         // Get all knight moves from the current square, removing moves to own pieces and the enemy king
-        Bitboard all_knight_moves = knight_attacks(from) & ~own & ~enemy_king;
+        Bitboard all_knight_moves = knight_attacks(from) & generation_targets(pos, side, type) & ~enemy_king;
         // For each generated knight move on the bitboard
         while (all_knight_moves) {
             // Get the target square from the knight moves
@@ -465,12 +473,10 @@ static inline void generate_knight_moves(const Position* pos, MoveList* list, in
 }
 
 // Function to generate moves for all bishops on the bitboard
-static inline void generate_bishop_moves(const Position* pos, MoveList* list, int side, const MagicData* magic) {
+static inline void generate_bishop_moves(const Position* pos, MoveList* list, int side, GenType type, const MagicData* magic) {
     if (!pos || !list) return;
    // Get the bishop bitboard for the current side
     Bitboard bishops = pos->pieces[side == WHITE ? WB : BB];
-    // Get the occupied squares for the current side
-    Bitboard own = pos->occupied[side];
     // Get the occupied squares for the opponent
     Bitboard opp = pos->occupied[side ^ 1];
     // Get all occupied squares
@@ -488,7 +494,7 @@ static inline void generate_bishop_moves(const Position* pos, MoveList* list, in
         }
         
         // Get all bishop moves from the current square, removing moves to own pieces and the enemy king
-        Bitboard all_bishop_moves = bishop_attacks(from, all, magic) & ~own & ~enemy_king;
+        Bitboard all_bishop_moves = bishop_attacks(from, all, magic) & generation_targets(pos, side, type) & ~enemy_king;
 
         // For each generated bishop move on the bitboard
         while (all_bishop_moves) {
@@ -507,12 +513,10 @@ static inline void generate_bishop_moves(const Position* pos, MoveList* list, in
 }
 
 // Function to generate moves for all rooks on the bitboard
-static inline void generate_rook_moves(const Position* pos, MoveList* list, int side, const MagicData* magic) {
+static inline void generate_rook_moves(const Position* pos, MoveList* list, int side, GenType type, const MagicData* magic) {
     if (!pos || !list) return;
     // Get the rook bitboard for the current side
     Bitboard rooks = pos->pieces[side == WHITE ? WR : BR];
-    // Get the occupied squares for the current side
-    Bitboard own = pos->occupied[side];
     // Get the occupied squares for the opponent
     Bitboard opp = pos->occupied[side ^ 1];
     // Get all occupied squares
@@ -530,7 +534,7 @@ static inline void generate_rook_moves(const Position* pos, MoveList* list, int
         }
 
         // Get all rook moves from the current square, removing moves to own pieces and the enemy king                    
-        Bitboard all_rook_moves = rook_attacks(from, all, magic) & ~own & ~enemy_king; 
+        Bitboard all_rook_moves = rook_attacks(from, all, magic) & generation_targets(pos, side, type) & ~enemy_king;
         
         // For each generated rook move on the bitboard
         while (all_rook_moves) {
@@ -549,12 +553,10 @@ static inline void generate_rook_moves(const Position* pos, MoveList* list, int
 }
 
 // Function to generate moves for all queens on the bitboard
-static inline void generate_queen_moves(const Position* pos, MoveList* list, int side, const MagicData* magic) {
+static inline void generate_queen_moves(const Position* pos, MoveList* list, int side, GenType type, const MagicData* magic) {
     if (!pos || !list) return;
     // Get the queen bitboard for the current side
     Bitboard queens = pos->pieces[side == WHITE ? WQ : BQ];
-    // Get the occupied squares for the current side
-    Bitboard own = pos->occupied[side];
     // Get the occupied squares for the opponent
     Bitboard opp = pos->occupied[side ^ 1];
     // Get all occupied squares
@@ -572,7 +574,7 @@ static inline void generate_queen_moves(const Position* pos, MoveList* list, int
         }
 
         // Get all queen moves from the current square, removing moves to own pieces and the enemy king
-        Bitboard all_queen_moves = queen_attacks(from, all, magic) & ~own & ~enemy_king;
+        Bitboard all_queen_moves = queen_attacks(from, all, magic) & generation_targets(pos, side, type) & ~enemy_king;
         
         // For each generated queen move on the bitboard
         while (all_queen_moves) {
@@ -591,17 +593,16 @@ static inline void generate_queen_moves(const Position* pos, MoveList* list, int
 }
 
 // Function to generate moves for all kings on the bitboard
-static inline void generate_king_moves(const Position* pos, MoveList* list, int side, const MagicData* magic) {
+static inline void generate_king_moves(const Position* pos, MoveList* list, int side, GenType type, const MagicData* magic) {
     if (!pos || !list) return;
 
     Bitboard king_bb = pos->pieces[side == WHITE ? WK : BK];
-    Bitboard own = pos->occupied[side];
     Bitboard opp = pos->occupied[side ^ 1];
     Bitboard enemy_king = pos->pieces[side ? WK : BK];
 
     while (king_bb) {
         int from = pop_lsb(&king_bb);
-        Bitboard moves = king_attacks(from) & ~own & ~enemy_king;
+        Bitboard moves = king_attacks(from) & generation_targets(pos, side, type) & ~enemy_king;
 
         while (moves) {
             int to = pop_lsb(&moves);
@@ -613,7 +614,7 @@ static inline void generate_king_moves(const Position* pos, MoveList* list, int
 
         int king_from = from;
         Bitboard occupied = pos->occupied[ALL];
-        if (!(pos->pieces[side == WHITE ? WK : BK] & (1ULL << king_from))) {
+        if (type == GEN_NOISY || !(pos->pieces[side == WHITE ? WK : BK] & (1ULL << king_from))) {
             continue;
         }
 
@@ -667,16 +668,16 @@ static inline void generate_king_moves(const Position* pos, MoveList* list, int
 
 // Check, checkmate, and stalemate detection
 int is_in_check(const Position* pos, int side, const MagicData* magic);
-int is_in_checkmate(const Position* pos, int side, const MagicData* magic, ZobristKeys* keys);
-int is_in_stalemate(const Position* pos, int side, const MagicData* magic, ZobristKeys* keys);
+int is_in_checkmate(const Position* pos, int side, const MagicData* magic, const ZobristKeys* keys);
+int is_in_stalemate(const Position* pos, int side, const MagicData* magic, const ZobristKeys* keys);
 
 // Make and unmake move
-int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys);
-int unmake_move(Position* pos, const MoveState* state, ZobristKeys* keys);
+int make_move(Position* pos, MoveState* state, int move, const ZobristKeys* keys);
+int unmake_move(Position* pos, const MoveState* state, const ZobristKeys* keys);
 
 /* ---------- Move generation functions ---------- */
 
-static inline int is_legal_move(const Position* pos, int move, const MagicData* magic, ZobristKeys* keys) {
+static inline int is_legal_move(const Position* pos, int move, const MagicData* magic, const ZobristKeys* keys) {
     if (!pos || move == 0) return 0;
 
     // Create a shallow copy of the Position struct
@@ -693,20 +694,159 @@ static inline int is_legal_move(const Position* pos, int move, const MagicData*
     return !in_check;
 }
 
-static inline void generate_pseudo_legal_moves(const Position* pos, MoveList* list, int side, const MagicData* magic) {
+// Fill in the checkers, pinned pieces and evasion squares for the given side
+static inline void compute_legality_info(const Position* pos, int side, LegalityInfo* info, const MagicData* magic) {
+    int king_sq = pos->king_from[side];
+    Bitboard own = pos->occupied[side];
+    Bitboard occ = pos->occupied[ALL];
+    int opp = side ^ 1;
+
+    info->king_sq = king_sq;
+    info->checkers = get_attackers_to(pos, king_sq, occ, magic) & pos->occupied[opp];
+    info->pinned = 0;
+
+    // Enemy sliders that would see the king on an empty board are potential pinners
+    Bitboard snipers =
+        (rook_attacks(king_sq, 0, magic) & (pos->pieces[opp * 6 + R] | pos->pieces[opp * 6 + Q])) |
+        (bishop_attacks(king_sq, 0, magic) & (pos->pieces[opp * 6 + B] | pos->pieces[opp * 6 + Q]));
+
+    while (snipers) {
+        int sniper_sq = pop_lsb(&snipers);
+        Bitboard blockers = squares_between_exclusive(king_sq, sniper_sq) & occ;
+        // Exactly one piece in between, and it is ours: it's pinned
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & own)) {
+            info->pinned |= blockers;
+        }
+    }
+
+    if (!info->checkers) {
+        info->check_mask = ~0ULL;
+    } else if (!(info->checkers & (info->checkers - 1))) {
+        // Single check: capture the checker or block the line between it and the king
+        int checker_sq = get_lsb(info->checkers);
+        info->check_mask = info->checkers | squares_between_exclusive(king_sq, checker_sq);
+    } else {
+        // Double check: only king moves can help
+        info->check_mask = 0;
+    }
+}
+
+// Legality test based on precomputed checkers and pins, without making the move
+static inline int is_legal_move_fast(const Position* pos, int move, const LegalityInfo* info, const MagicData* magic, const ZobristKeys* keys) {
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flag = MOVE_FLAG(move);
+
+    // En passant removes two pieces from the board and castling moves the rook too: use the full test
+    if (flag == EN_PASSANT || flag == CASTLE_KINGSIDE || flag == CASTLE_QUEENSIDE) {
+        return is_legal_move(pos, move, magic, keys);
+    }
+
+    if (from == info->king_sq) {
+        // The king may not step onto an attacked square, including squares it currently shields from a slider
+        int side = pos->side_to_move;
+        Bitboard occ = pos->occupied[ALL] & ~(1ULL << from);
+        return !(get_attackers_to(pos, to, occ, magic) & pos->occupied[side ^ 1]);
+    }
+
+    // Non-king moves must resolve a check
+    if (!(info->check_mask & (1ULL << to))) return 0;
+
+    // A pinned piece may only move along the line through the king and its pinner
+    if (info->pinned & (1ULL << from)) {
+        return squares_aligned(info->king_sq, from, to);
+    }
+
+    return 1;
+}
+
+// Cheap test that a move taken from outside the generator (TT, killer or counter move) could have
+// been generated in this position. It says nothing about the king being left in check.
+static inline int is_pseudo_legal_move(const Position* pos, int move, const MagicData* magic) {
+    if (!pos || move == 0) return 0;
+
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flag = MOVE_FLAG(move);
+    int side = pos->side_to_move;
+
+    // The moving piece has to belong to the side to move
+    int piece = get_piece_on_square(pos, from);
+    if (piece < 0 || piece / 6 != side) return 0;
+    int type = piece % 6;
+
+    // Castling is validated against the castling generator, which knows about rights, paths and Chess960 rooks
+    if (flag == CASTLE_KINGSIDE || flag == CASTLE_QUEENSIDE) {
+        if (type != K) return 0;
+        MoveList king_moves;
+        king_moves.count = 0;
+        generate_king_moves(pos, &king_moves, side, GEN_QUIET, magic);
+        for (int i = 0; i < king_moves.count; i++) {
+            if (king_moves.moves[i] == move) return 1;
+        }
+        return 0;
+    }
+
+    int target = get_piece_on_square(pos, to);
+    int is_capture = (flag == CAPTURE || (flag >= PROMOTE_N_CAPTURE && flag <= PROMOTE_Q_CAPTURE));
+    int is_promotion = (flag >= PROMOTE_N && flag <= PROMOTE_Q_CAPTURE);
+
+    // Captures need an enemy piece (never the king) on the target square, everything else an empty one
+    if (flag == EN_PASSANT) {
+        if (type != P || to != pos->en_passant || target != -1) return 0;
+    } else if (is_capture) {
+        if (target < 0 || target / 6 == side || target % 6 == K) return 0;
+    } else if (target != -1) {
+        return 0;
+    }
+
+    if (type == P) {
+        int forward = (side == WHITE) ? 8 : -8;
+        int last_rank = (side == WHITE) ? 7 : 0;
+        // Promotion flags and the last rank go together
+        if (is_promotion != ((to >> 3) == last_rank)) return 0;
+
+        if (flag == EN_PASSANT || is_capture) {
+            int file_diff = (to & 7) - (from & 7);
+            return (file_diff == 1 || file_diff == -1) && (to >> 3) == (from >> 3) + forward / 8;
+        }
+        if (flag == DOUBLE_PUSH) {
+            int start_rank = (side == WHITE) ? 1 : 6;
+            return (from >> 3) == start_rank && to == from + 2 * forward &&
+                   get_piece_on_square(pos, from + forward) == -1;
+        }
+        return to == from + forward;
+    }
+
+    // Pieces other than pawns only make plain moves and captures
+    if (flag != QUIET && flag != CAPTURE) return 0;
+
+    Bitboard occ = pos->occupied[ALL];
+    Bitboard attacks;
+    switch (type) {
+        case N: attacks = knight_attacks(from); break;
+        case B: attacks = bishop_attacks(from, occ, magic); break;
+        case R: attacks = rook_attacks(from, occ, magic); break;
+        case Q: attacks = queen_attacks(from, occ, magic); break;
+        default: attacks = king_attacks(from); break;
+    }
+    return (attacks & (1ULL << to)) != 0;
+}
+
+static inline void generate_pseudo_legal_moves(const Position* pos, MoveList* list, int side, GenType type, const MagicData* magic) {
     if (!pos || !list) return;
-    memset(list->moves, 0, MAX_MOVES * sizeof(int));
     list->count = 0; // Reset move count
 
     // Generate moves for each piece type
-    generate_pawn_moves(pos, list, side);
-    generate_knight_moves(pos, list, side);
-    generate_bishop_moves(pos, list, side, magic);
-    generate_rook_moves(pos, list, side, magic);
-    generate_queen_moves(pos, list, side, magic);
-    generate_king_moves(pos, list, side, magic);
+    generate_pawn_moves(pos, list, side, type);
+    generate_knight_moves(pos, list, side, type);
+    generate_bishop_moves(pos, list, side, type, magic);
+    generate_rook_moves(pos, list, side, type, magic);
+    generate_queen_moves(pos, list, side, type, magic);
+    generate_king_moves(pos, list, side, type, magic);
 }
 
-void generate_legal_moves(const Position* pos, MoveList* list, int side, const MagicData* magic, ZobristKeys* keys);
+void generate_moves(const Position* pos, MoveList* list, int side, GenType type, const LegalityInfo* info, const MagicData* magic, const ZobristKeys* keys);
+void generate_legal_moves(const Position* pos, MoveList* list, int side, const MagicData* magic, const ZobristKeys* keys);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "board.h"
+#include "evalsearch.h"
+#include "magic.h"
+#include "movegen.h"
+#include "zobrist.h"
+
+// Stages of the move picker, in the order the moves are handed out. Each generating stage only
+// runs once every earlier stage is exhausted, so a node that cuts off on the TT move or a good
+// capture never generates (let alone scores) its quiet moves.
+typedef enum {
+    STAGE_TT_MOVE,
+    STAGE_INIT_CAPTURES,
+    STAGE_GOOD_CAPTURES,
+    STAGE_KILLER_1,
+    STAGE_KILLER_2,
+    STAGE_COUNTER_MOVE,
+    STAGE_INIT_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+    STAGE_DONE,
+
+    // Quiescence search: captures and queen promotions only, losing captures are dropped
+    STAGE_QS_INIT_CAPTURES,
+    STAGE_QS_CAPTURES
+} PickerStage;
+
+typedef struct {
+    const SearchThread* td; // NULL in quiescence search, which needs no quiet move heuristics
+    const Position* pos;
+    const MagicData* magic;
+    const ZobristKeys* keys;
+    LegalityInfo info; // Checkers and pins, shared by the generators and the special move checks
+
+    PickerStage stage;
+    int tt_move;
+    int killers[2];
+    int counter_move;
+    int specials[3]; // Killers and counter move already handed out, skipped by the quiet stage
+    int special_count;
+
+    // Moves of the current generating stage with their scores, handed out by partial selection sort
+    MoveList moves;
+    int scores[MAX_MOVES];
+    int index;
+
+    // Captures that lose material according to SEE, tried after the quiet moves
+    int bad_captures[MAX_MOVES];
+    int bad_count;
+    int bad_index;
+} MovePicker;
+
+void init_move_picker(MovePicker* mp, const SearchThread* td, const Position* pos, int ply,
+                      int tt_move, int counter_move, const MagicData* magic, const ZobristKeys* keys);
+void init_qsearch_picker(MovePicker* mp, const Position* pos, const MagicData* magic, const ZobristKeys* keys);
+int next_move(MovePicker* mp);
+
+#endif
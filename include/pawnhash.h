@@ -0,0 +1,29 @@
+#ifndef PAWNHASH_H
+#define PAWNHASH_H
+
+#include "board.h"
+#include "evalparams.h"
+#include <stdint.h>
+
+#define PAWN_TABLE_SIZE 16384 // Entries, must be a power of two
+
+// Everything the evaluation derives from the pawns alone. Pawn structure rarely changes between
+// neighbouring nodes, so these are computed once per pawn configuration and looked up by pawn_hash.
+typedef struct {
+    uint64_t key;
+    Bitboard passed[2];      // Passed pawns of each side
+    Bitboard attacks[2];     // Squares attacked by the pawns of each side
+    Bitboard attack_span[2]; // Squares the pawns of each side attack now or after advancing
+    int mg;                  // Pawn structure score from white's point of view
+    int eg;
+} PawnEntry;
+
+// Direct-mapped and owned by a single search thread, so it needs no synchronisation
+typedef struct {
+    PawnEntry entries[PAWN_TABLE_SIZE];
+} PawnTable;
+
+void evaluate_pawn_structure(const Position* pos, const EvalParams* params, PawnEntry* entry);
+const PawnEntry* probe_pawn_table(PawnTable* table, const Position* pos, const EvalParams* params);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "board.h"
+#include "magic.h"
+#include "zobrist.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define PERFT_HASH_DEFAULT_MB 64
+#define PERFT_SUITE_HASH_MB 16   // Per worker thread
+#define PERFT_SUITE_MAX_DEPTHS 16 // Expected counts per EPD line, D1 to D16
+
+// Subtree counts keyed by Zobrist hash and remaining depth. Entries are simply overwritten,
+// a perft run is short and recomputing an evicted subtree is always correct.
+typedef struct {
+    uint64_t key;
+    uint64_t data; // Node count in the upper 56 bits, depth in the lower 8
+} PerftEntry;
+
+// Owned by one perft run at a time, so it needs no synchronisation
+typedef struct {
+    PerftEntry* entries;
+    uint64_t mask; // Entry count - 1, the count is a power of two
+} PerftTable;
+
+int perft_table_init(PerftTable* table, size_t size_mb);
+void perft_table_free(PerftTable* table);
+
+// Number of leaf nodes depth plies below pos. Moves at the last ply are counted, not made, and
+// table may be NULL to search without the subtree cache.
+uint64_t perft(Position* pos, int depth, PerftTable* table, const MagicData* magic, const ZobristKeys* keys);
+
+// Prints the count below every root move and the total, as "go perft" does
+uint64_t perft_divide_uci(Position* pos, int depth, PerftTable* table, const MagicData* magic, const ZobristKeys* keys);
+
+// Runs every position of an EPD perft suite ("<fen> ;D1 20 ;D2 400 ...") on a pool of worker
+// threads, skipping depths above max_depth (0: no limit). Returns the number of wrong counts, or
+// -1 if the file cannot be read.
+int run_perft_suite(const char* path, int threads, int max_depth, const MagicData* magic, const ZobristKeys* keys);
+
+#endif
@@ -1,10 +1,24 @@
 #ifndef TEST_H
 #define TEST_H
 
+#include "board.h"
+#include "magic.h"
+#include "zobrist.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 bool is_position_valid(const Position* pos);
-uint64_t perft_debug(Position* pos, int depth, const MagicData* magic, ZobristKeys* keys);
-void perft_divide(Position* pos, int depth, const MagicData* magic, ZobristKeys* keys);
+uint64_t perft_debug(Position* pos, int depth, const MagicData* magic, const ZobristKeys* keys);
+void perft_divide(Position* pos, int depth, const MagicData* magic, const ZobristKeys* keys);
+uint64_t tt_stress_test(int thread_count, int iterations);
+int geometry_test(const MagicData* magic);
+int slider_backend_test(const MagicData* magic);
+int zobrist_key_test(const MagicData* magic, const ZobristKeys* keys);
+int perft_test(const MagicData* magic, const ZobristKeys* keys);
+int move_picker_test(const MagicData* magic, const ZobristKeys* keys);
+int cuckoo_test(const MagicData* magic, const ZobristKeys* keys);
+int repetition_test(const MagicData* magic, const ZobristKeys* keys);
+int incremental_eval_test(const MagicData* magic, const ZobristKeys* keys);
+int run_self_tests(const MagicData* magic, const ZobristKeys* keys);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,50 @@
+#ifndef TIMEMAN_H
+#define TIMEMAN_H
+
+#include <stdint.h>
+
+#define DEFAULT_MOVE_OVERHEAD 30 // Milliseconds kept in reserve per move for GUI and network lag
+#define MAX_MOVE_OVERHEAD 5000
+
+// Limits of one search as given by the UCI go command, 0 where the command did not set them
+typedef struct {
+    int time[2];   // wtime, btime
+    int inc[2];    // winc, binc
+    int movestogo;
+    int movetime;
+    int depth;
+    int infinite;
+    int ponder;    // Searching on the opponent's time, the limits apply from ponderhit on
+} SearchLimits;
+
+// The soft limit is checked between iterations (no new iteration is started past it), the hard
+// limit is polled inside the search and aborts it
+typedef struct {
+    int64_t start;      // Monotonic clock in milliseconds when the search started
+    int64_t soft_limit; // Milliseconds after start
+    int64_t hard_limit;
+    int active;         // 0 when the search is only bounded by depth or a stop command
+} TimeManager;
+
+int64_t time_now_ms(void);
+void sleep_ms(int ms);
+void init_time_manager(TimeManager* tm, const SearchLimits* limits, int side, int move_overhead);
+
+static inline int64_t time_elapsed_ms(const TimeManager* tm) {
+    return time_now_ms() - tm->start;
+}
+
+// On ponderhit the time for the move starts counting, the limits stay as computed for the go command
+static inline void time_restart(TimeManager* tm) {
+    tm->start = time_now_ms();
+}
+
+static inline int time_soft_exceeded(const TimeManager* tm) {
+    return tm && tm->active && time_elapsed_ms(tm) >= tm->soft_limit;
+}
+
+static inline int time_hard_exceeded(const TimeManager* tm) {
+    return tm && tm->active && time_elapsed_ms(tm) >= tm->hard_limit;
+}
+
+#endif
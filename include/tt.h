@@ -1,9 +1,15 @@
 #ifndef TT_H
 #define TT_H
 
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 
-#define TT_SIZE (1 << 20)  // 1 million entries ~ 16 MB if each entry ~16 bytes
+#define TT_DEFAULT_MB 16
+#define TT_MAX_MB 65536
+#define TT_BUCKET_SIZE 4   // 4 entries x 16 bytes = one 64-byte cache line
+#define TT_GENERATIONS 64  // Generation counter wraps around after 6 bits
+#define TT_EVAL_NONE -32768 // Stored static eval when none was computed
 
 typedef enum {
     TT_NONE,
@@ -12,22 +18,87 @@ typedef enum {
     TT_BETA       // upper bound (fail high)
 } TTFlag;
 
+// Outcome of tt_probe: a hit provides the stored move and eval, a cutoff also settles the node
+typedef enum {
+    TT_PROBE_MISS,
+    TT_PROBE_HIT,
+    TT_PROBE_CUTOFF
+} TTProbe;
+
+// The table is shared by all search threads without a lock. Each entry is two independent
+// 64-bit words, and the key word holds the Zobrist hash XORed with the data word: a reader
+// that sees halves from two different stores fails the key check instead of using torn data.
+//
+// Data word layout:
+//   bits  0-15  best move (moves are encoded in 16 bits)
+//   bits 16-31  score, mate scores compressed into 16 bits
+//   bits 32-39  search depth
+//   bits 40-47  search generation (upper 6 bits) | TTFlag (lower 2 bits)
+//   bits 48-63  static evaluation of the position, TT_EVAL_NONE if unknown
 typedef struct {
-    uint64_t key;    // Zobrist hash key (position identifier)
-    int depth;       // Search depth at which this was stored
-    int score;       // Evaluated score of the position
-    int best_move;   // Best move found in this position
-    TTFlag flag;     // Type of entry
+    _Atomic uint64_t key;
+    _Atomic uint64_t data;
 } TTEntry;
 
-extern TTEntry transposition_table[TT_SIZE];
+typedef struct {
+    TTEntry entries[TT_BUCKET_SIZE];
+} TTBucket;
+
+typedef struct {
+    TTBucket* buckets;
+    uint64_t bucket_count;
+    uint8_t generation;
+} TranspositionTable;
+
+extern TranspositionTable transposition_table;
+
+static inline TTBucket* tt_bucket(uint64_t key) {
+    // Map the key onto [0, bucket_count) without requiring a power-of-two table size
+    return &transposition_table.buckets[(uint64_t)(((unsigned __int128)key * transposition_table.bucket_count) >> 64)];
+}
+
+static inline uint64_t tt_pack(int best_move, int16_t score, int depth, int gen_flag, int16_t eval) {
+    return (uint64_t)(uint16_t)best_move
+         | (uint64_t)(uint16_t)score << 16
+         | (uint64_t)(uint8_t)depth << 32
+         | (uint64_t)(uint8_t)gen_flag << 40
+         | (uint64_t)(uint16_t)eval << 48;
+}
+
+static inline int tt_data_move(uint64_t data) {
+    return (int)(data & 0xFFFF);
+}
+
+static inline int16_t tt_data_score(uint64_t data) {
+    return (int16_t)(uint16_t)(data >> 16);
+}
+
+static inline int tt_data_depth(uint64_t data) {
+    return (int)((data >> 32) & 0xFF);
+}
+
+static inline int tt_data_eval(uint64_t data) {
+    return (int16_t)(uint16_t)(data >> 48);
+}
+
+static inline int tt_data_gen_flag(uint64_t data) {
+    return (int)((data >> 40) & 0xFF);
+}
+
+static inline TTFlag tt_data_flag(uint64_t data) {
+    return (TTFlag)(tt_data_gen_flag(data) & 3);
+}
 
-static inline int tt_index(uint64_t key) {
-    return (int)(key & (TT_SIZE - 1));
+static inline int tt_data_age(uint64_t data) {
+    return (transposition_table.generation - (tt_data_gen_flag(data) >> 2)) & (TT_GENERATIONS - 1);
 }
 
+int tt_resize(size_t size_mb);
+size_t tt_size_mb(void);
 void tt_init();
-void tt_store(uint64_t key, int depth, int score, int best_move, TTFlag flag);
-int tt_probe(uint64_t key, int depth, int alpha, int beta, int* out_score, int* out_move);
+void tt_new_search();
+void tt_store(uint64_t key, int depth, int score, int static_eval, int best_move, TTFlag flag);
+TTProbe tt_probe(uint64_t key, int depth, int alpha, int beta, int* out_score, int* out_move, int* out_eval);
+int tt_hashfull(void);
 
-#endif
\ No newline at end of file
+#endif
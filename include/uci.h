@@ -7,7 +7,7 @@
 #include "zobrist.h"
 
 void move_to_uci(int move, char out[6]);
-int parse_move(const Position* pos, const char* uci_str, const MagicData* magic, ZobristKeys* keys);
-void uci_loop(Position* pos, MoveList* list, MoveState* state, int depth, const MagicData* magic, ZobristKeys* keys);
+int parse_move(const Position* pos, const char* uci_str, const MagicData* magic, const ZobristKeys* keys);
+void uci_loop(Position* pos, MoveList* list, MoveState* state, int depth, const MagicData* magic, const ZobristKeys* keys);
 
 #endif
\ No newline at end of file
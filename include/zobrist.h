@@ -11,7 +11,21 @@ typedef struct {
     Bitboard zobrist_en_passant[8]; // en passant files (0-7)
 } ZobristKeys;
 
-void init_zobrist(ZobristKeys* keys);
-uint64_t compute_zobrist_hash(const Position* pos, ZobristKeys* keys);
+// Fixed keys, the same on every platform and build
+extern const ZobristKeys zobrist_keys;
+
+// Cuckoo hash of every reversible piece move (no pawns, no castling), keyed by the change it makes
+// to the Zobrist hash: piece on from ^ piece on to ^ side. The search looks up the difference
+// between the current key and an earlier one to spot a move that returns to that position.
+#define CUCKOO_SIZE 8192
+#define CUCKOO_H1(key) ((int)((key) & (CUCKOO_SIZE - 1)))
+#define CUCKOO_H2(key) ((int)(((key) >> 16) & (CUCKOO_SIZE - 1)))
+
+extern uint64_t cuckoo_keys[CUCKOO_SIZE];
+extern uint16_t cuckoo_moves[CUCKOO_SIZE]; // from << 6 | to as in the move encoding, 0 for an empty slot
+
+uint64_t compute_zobrist_hash(const Position* pos, const ZobristKeys* keys);
+uint64_t compute_pawn_hash(const Position* pos, const ZobristKeys* keys);
+int init_cuckoo(const ZobristKeys* keys);
 
 #endif
\ No newline at end of file
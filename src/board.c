@@ -1,4 +1,5 @@
 #include "board.h"
+#include "evalparams.h"
 #include "moveformat.h"
 #include "movegen.h"
 #include "operations.h"
@@ -22,48 +23,6 @@ int piece_index(char c) {
     }
 }
 
-Bitboard squares_between_inclusive(int a, int b) {
-    Bitboard bb = 0;
-    if (a == b) return 1ULL << a;
-
-    int step = 0;
-
-    if (RANK(a) == RANK(b)) step = (b > a) ? 1 : -1;
-    else if (FILE(a) == FILE(b)) step = (b > a) ? 8 : -8;
-    else if (abs(FILE(a) - FILE(b)) == abs(RANK(a) - RANK(b))) {
-        step = (b > a) ? ((FILE(b) > FILE(a)) ? 9 : 7) : ((FILE(b) > FILE(a)) ? -7 : -9);
-    } else return 0;
-
-    for (int sq = a; ; sq += step) {
-        bb |= 1ULL << sq;
-        if (sq == b) break;
-    }
-    return bb;
-}
-
-Bitboard squares_between_exclusive(int a, int b) {
-    if (a == b) return 0;
-    Bitboard bb = 0;
-
-    int step = 0;
-
-    if (RANK(a) == RANK(b)) {
-        step = (b > a) ? 1 : -1;
-    } else if (FILE(a) == FILE(b)) {
-        step = (b > a) ? 8 : -8;
-    } else if (abs(FILE(a) - FILE(b)) == abs(RANK(a) - RANK(b))) {
-        step = (b > a) ? ((FILE(b) > FILE(a)) ? 9 : 7)
-                      : ((FILE(b) > FILE(a)) ? -7 : -9);
-    } else {
-        return 0;
-    }
-
-    for (int sq = a + step; sq != b; sq += step)
-        bb |= 1ULL << sq;
-
-    return bb;
-}
-
 void print_position(const Position* pos) {
     if (!pos) return;
 
@@ -111,13 +70,7 @@ void print_board(const Position* pos) {
         printf("%d |", rank + 1);
         for (int file = 0; file < 8; file++) {
             int sq = rank * 8 + file;
-            char piece = '.';
-            for (int i = 0; i < 12; i++) {
-                if (pos->pieces[i] & (1ULL << sq)) {
-                    piece = piece_chars[i];
-                    break;
-                }
-            }
+            char piece = (pos->mailbox[sq] != -1) ? piece_chars[pos->mailbox[sq]] : '.';
             printf(" %c", piece);
         }
         printf(" |\n");
@@ -130,6 +83,7 @@ void print_board(const Position* pos) {
 void init_position(Position* pos, const char* fen) {
     // Clear position
     memset(pos, 0, sizeof(Position));
+    memset(pos->mailbox, -1, sizeof(pos->mailbox));
     pos->en_passant = -1;
     
     // Prepare FEN for parsing
@@ -158,6 +112,7 @@ void init_position(Position* pos, const char* fen) {
             int index = piece_index(*c);
             if (index >= 0) {
                 pos->pieces[index] |= 1ULL << square;
+                pos->mailbox[square] = index;
                 pos->occupied[index < 6 ? 0 : 1] |= 1ULL << square;
                 pos->occupied[ALL] |= 1ULL << square;
 
@@ -213,9 +168,12 @@ void init_position(Position* pos, const char* fen) {
     // Parse fullmove number
     token = strtok(NULL, " ");
     pos->fullmove_number = atoi(token);
+
+    // From here on make_move() keeps the evaluation accumulators up to date
+    refresh_psq_state(pos);
 }
 
-void print_moves(const Position* pos, const MoveList* list, const MagicData* magic, ZobristKeys* keys) {
+void print_moves(const Position* pos, const MoveList* list, const MagicData* magic, const ZobristKeys* keys) {
     static const char* flag_names[] = {
         "QUIET", "CAPTURE", "DOUBLE_PUSH", "EN_PASSANT",
         "CASTLE_QUEENSIDE", "CASTLE_KINGSIDE",
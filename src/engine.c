@@ -1,14 +1,20 @@
 #include "engine.h"
+#include "evalparams.h"
+#include "geometry.h"
 #include "magic.h"
 #include "movegen.h"
 #include "zobrist.h"
 #include <stdio.h>
 #include <stdlib.h>
 
-void init_engine(MagicData* magic, ZobristKeys* keys) {
+// The slider attack tables and the Zobrist keys need no initialisation, they are compiled in as
+// magic_data and zobrist_keys. The cuckoo tables are derived from the keys and the geometry.
+void init_engine(void) {
     srand(0);
-    init_magic(magic);
-    printf("Magic initialized.\n");
-    init_zobrist(keys);
-    printf("Zobrist initialized.\n");
+    init_geometry();
+    init_cuckoo(&zobrist_keys);
+    EvalParams params;
+    set_default_evalparams(&params);
+    init_psq_tables(&params);
+    tt_resize(TT_DEFAULT_MB);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "evalparams.h"
 #include "movegen.h"
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -490,4 +491,60 @@ void init_double_params(EvalParamsDouble* d) {
             d->king_zone_attacker_eg[piece_type][attacker_count] = (double)i.king_zone_attacker_eg[piece_type][attacker_count];
         }
     }
-}
\ No newline at end of file
+}
+
+int psq_mg[12][64];
+int psq_eg[12][64];
+
+const int phase_weight[6] = { 0, 1, 1, 2, 4, 0 }; // P, N, B, R, Q, K
+
+// Parameters the tables were last built from. Material and PST are the leading fields of
+// EvalParams, up to the first positional term.
+#define PSQ_PARAMS_SIZE offsetof(EvalParams, passed_pawn_bonus_mg)
+static EvalParams psq_source;
+static int psq_built = 0;
+
+void init_psq_tables(const EvalParams* p) {
+    psq_source = *p;
+    psq_built = 1;
+
+    const int* pst_mg[6] = { p->pawn_pst_mg, p->knight_pst_mg, p->bishop_pst_mg, p->rook_pst_mg, p->queen_pst_mg, p->king_pst_mg };
+    const int* pst_eg[6] = { p->pawn_pst_eg, p->knight_pst_eg, p->bishop_pst_eg, p->rook_pst_eg, p->queen_pst_eg, p->king_pst_eg };
+
+    for (int type = P; type <= K; type++) {
+        for (int sq = 0; sq < 64; sq++) {
+            // The tables are laid out from white's side, black pieces use the mirrored square and count negative
+            psq_mg[type][sq] = p->mg_value[type] + pst_mg[type][sq];
+            psq_eg[type][sq] = p->eg_value[type] + pst_eg[type][sq];
+            psq_mg[type + 6][sq] = -(p->mg_value[type] + pst_mg[type][MIRROR(sq)]);
+            psq_eg[type + 6][sq] = -(p->eg_value[type] + pst_eg[type][MIRROR(sq)]);
+        }
+    }
+}
+
+// Rebuilds the tables when p has other material or PST values than they were built from.
+// Returns 1 when it did; accumulators of existing positions are then stale.
+int use_psq_tables(const EvalParams* p) {
+    if (psq_built && memcmp(&psq_source, p, PSQ_PARAMS_SIZE) == 0) return 0;
+    init_psq_tables(p);
+    return 1;
+}
+
+// Full recompute of the incrementally updated evaluation terms
+void compute_psq_state(const Position* pos, int* mg, int* eg, int* phase) {
+    *mg = *eg = *phase = 0;
+
+    for (int piece = 0; piece < 12; piece++) {
+        Bitboard bb = pos->pieces[piece];
+        while (bb) {
+            int sq = pop_lsb(&bb);
+            *mg += psq_mg[piece][sq];
+            *eg += psq_eg[piece][sq];
+            *phase += phase_weight[piece % 6];
+        }
+    }
+}
+
+void refresh_psq_state(Position* pos) {
+    compute_psq_state(pos, &pos->psq_mg, &pos->psq_eg, &pos->phase);
+}
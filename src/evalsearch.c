@@ -3,19 +3,33 @@
 #include "evalsearch.h"
 #include "evalparams.h"
 #include "movegen.h"
+#include "movepick.h"
 #include "tt.h"
+#include "uci.h"
 #include "zobrist.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-#define DRAW_SCORE 0
-#define DRAW_PENALTY -20
-
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#define ASPIRATION_WINDOW 50       // Initial half width around the previous iteration's score
+#define ASPIRATION_MIN_DEPTH 3
+#define ASPIRATION_MAX_WINDOW 1000 // Past this the window opens fully
 
-int killer_moves[MAX_PLY][2];
-int history_table[64][64];
-int counter_moves[64][64]; // New: counter-move heuristic
+atomic_int search_stopped;
+atomic_int stop_requested;
+atomic_int search_pondering;
+static int search_threads = 1;
+static uint64_t last_search_nodes = 0;
+static int last_search_score = 0;
+
+// Threads of the running search, so that the main thread can report the nodes of all of them
+static SearchThread* search_pool = NULL;
+static int search_pool_size = 0;
+static int64_t search_start_ms = 0;
 
 int piece_values[] = {
     100, 300, 300, 500, 900, 10000
@@ -40,27 +54,127 @@ const int phase_values[6] = {
     0  // King
 };
 
-#define MAX_REP_HISTORY 1024
-uint64_t repetition_table[MAX_REP_HISTORY];
-int repetition_index = 0;
+void set_search_threads(int count) {
+    if (count < 1) count = 1;
+    if (count > MAX_THREADS) count = MAX_THREADS;
+    search_threads = count;
+}
 
-// New: Move scoring constants
-#define SCORE_TT_MOVE        1000000
-#define SCORE_GOOD_CAPTURE    900000
-#define SCORE_KILLER_1        800000
-#define SCORE_KILLER_2        700000
-#define SCORE_CASTLE          600000
-#define SCORE_BAD_CAPTURE     100000
-#define SCORE_QUIET              0
+// Nodes searched by all threads during the last find_best_move()
+uint64_t get_search_nodes(void) {
+    return last_search_nodes;
+}
 
-bool is_threefold_repetition(uint64_t hash) {
-    int count = 0;
-    for (int i = 0; i < repetition_index; i++) {
-        if (repetition_table[i] == hash) {
-            if (++count >= 2) return true;  // third occurrence
+// Score of the move returned by the last find_best_move(), side to move's point of view
+int get_search_score(void) {
+    return last_search_score;
+}
+
+int get_search_threads(void) {
+    return search_threads;
+}
+
+// Static evaluation through the per-thread cache: the pruning decisions of a node and the
+// quiescence search below it often evaluate the very same position
+static int cached_evaluation(SearchThread* td, const Position* pos, const EvalParams* params, const MagicData* magic) {
+    EvalCacheEntry* entry = &td->eval_cache[pos->zobrist_hash & (EVAL_CACHE_SIZE - 1)];
+    if (entry->valid && entry->key == pos->zobrist_hash) {
+        return entry->score;
+    }
+
+    int score = evaluation(pos, params, magic, &td->pawn_table);
+    entry->key = pos->zobrist_hash;
+    entry->score = score;
+    entry->valid = 1;
+    return score;
+}
+
+// Upcoming repetition: a single reversible move of the side to move leads back to a position of the
+// current line, found by looking up the key difference in the cuckoo tables. Odd distances only,
+// the earlier position must have the opponent to move.
+static int has_upcoming_cycle(const SearchThread* td, const Position* pos, int ply) {
+    int end = pos->halfmove_clock < td->repetition_index ? pos->halfmove_clock : td->repetition_index;
+    if (end < 3) return 0;
+
+    const uint64_t* history = td->repetition_table + td->repetition_index;
+    Bitboard occupied = pos->occupied[ALL];
+
+    for (int i = 3; i <= end; i += 2) {
+        uint64_t move_key = pos->zobrist_hash ^ history[-i];
+        int slot = CUCKOO_H1(move_key);
+        if (cuckoo_keys[slot] != move_key) {
+            slot = CUCKOO_H2(move_key);
+            if (cuckoo_keys[slot] != move_key) continue;
+        }
+
+        // The squares in between have to be empty for the move to be possible
+        int s1 = MOVE_FROM(cuckoo_moves[slot]);
+        int s2 = MOVE_TO(cuckoo_moves[slot]);
+        if (between_table[s1][s2] & occupied) continue;
+
+        // Going back to a position inside the tree is a twofold repetition
+        if (ply > i) return 1;
+
+        // At or before the root the mover has to be ours, and the position must already have occurred
+        // twice, so that reaching it again is a threefold repetition
+        int piece = get_piece_on_square(pos, ((occupied >> s1) & 1) ? s1 : s2);
+        if (piece < 0 || piece / 6 != pos->side_to_move) continue;
+        for (int j = i + 4; j <= end; j += 2) {
+            if (history[-j] == history[-i]) return 1;
         }
     }
-    return false;
+    return 0;
+}
+
+// Plain load and store rather than an atomic increment: only the owning thread writes the counter
+static inline uint64_t count_node(SearchThread* td) {
+    uint64_t nodes = atomic_load_explicit(&td->nodes, memory_order_relaxed) + 1;
+    atomic_store_explicit(&td->nodes, nodes, memory_order_relaxed);
+    return nodes;
+}
+
+static uint64_t total_search_nodes(void) {
+    uint64_t nodes = 0;
+    for (int i = 0; i < search_pool_size; i++) {
+        nodes += atomic_load_explicit(&search_pool[i].nodes, memory_order_relaxed);
+    }
+    return nodes;
+}
+
+// Acquire pairs with the release in ponderhit, so that the restarted clock is visible with the cleared flag
+static inline int search_is_pondering(void) {
+    return atomic_load_explicit(&search_pondering, memory_order_acquire);
+}
+
+static inline int search_is_stopped(void) {
+    return atomic_load_explicit(&search_stopped, memory_order_relaxed);
+}
+
+#define LIMIT_CHECK_NODES 2048 // Nodes between two checks of the clock and the stop request
+
+// Only the main thread looks at the clock; the helpers follow search_stopped. The hard limit is
+// ignored until the first iteration is complete, so that there always is a move to play, and
+// while pondering.
+static inline void check_search_limits(SearchThread* td, uint64_t nodes) {
+    if (td->id != 0 || (nodes & (LIMIT_CHECK_NODES - 1)) != 0) return;
+
+    if (atomic_load_explicit(&stop_requested, memory_order_relaxed) ||
+        (td->completed_depth > 0 && !search_is_pondering() && time_hard_exceeded(td->time))) {
+        atomic_store_explicit(&search_stopped, 1, memory_order_relaxed);
+    }
+}
+
+// A position repeated inside the search tree is scored as a draw right away (twofold); one that only
+// occurred at or before the root needs two earlier occurrences (threefold). Only the last
+// halfmove_clock plies can hold the same position, and only every second ply has the same side to move.
+static int is_repetition(const SearchThread* td, const Position* pos, int ply) {
+    int end = pos->halfmove_clock < td->repetition_index ? pos->halfmove_clock : td->repetition_index;
+    int count = 0;
+    for (int i = 4; i <= end; i += 2) {
+        if (td->repetition_table[td->repetition_index - i] != pos->zobrist_hash) continue;
+        if (i < ply || ++count >= 2) return 1;
+    }
+    return 0;
 }
 
 int compute_phase(const Position* pos) {
@@ -81,84 +195,29 @@ int compute_phase(const Position* pos) {
     return phase;
 }
 
-void make_null_move(Position* pos, ZobristKeys* keys) {
+// The null move cancels en passant and resets the halfmove clock, so that the repetition scan does
+// not reach across it. unmake_null_move restores all three from the state.
+void make_null_move(Position* pos, MoveState* state, const ZobristKeys* keys) {
+    state->en_passant = pos->en_passant;
+    state->halfmove_clock = pos->halfmove_clock;
+    state->zobrist_hash = pos->zobrist_hash;
+
     pos->zobrist_hash ^= keys->zobrist_side;
+    if (pos->en_passant != -1) pos->zobrist_hash ^= keys->zobrist_en_passant[pos->en_passant % 8];
     pos->side_to_move ^= 1;
-    pos->en_passant = -1;  // Null move cancels en passant
+    pos->en_passant = -1;
+    pos->halfmove_clock = 0;
 }
 
-void unmake_null_move(Position* pos, ZobristKeys* keys) {
+void unmake_null_move(Position* pos, const MoveState* state) {
     pos->side_to_move ^= 1;
-    pos->zobrist_hash ^= keys->zobrist_side;
-}
-
-// Enhanced move scoring function
-int score_move(const Position* pos, int move, int ply, int tt_move, const MagicData* magic) {
-    if (move == tt_move) return SCORE_TT_MOVE;
-    
-    int flag = MOVE_FLAG(move);
-    
-    // Captures
-    if (flag == CAPTURE || flag == PROMOTE_N_CAPTURE || flag == PROMOTE_B_CAPTURE || 
-        flag == PROMOTE_R_CAPTURE || flag == PROMOTE_Q_CAPTURE) {
-        
-        int see_score = see(pos, move, magic);
-        if (see_score >= 0) {
-            int from = MOVE_FROM(move);
-            int to = MOVE_TO(move);
-            int captured = get_piece_on_square(pos, to);
-            int attacker = get_piece_on_square(pos, from);
-            return SCORE_GOOD_CAPTURE + 10 * piece_values[captured % 6] - piece_values[attacker % 6];
-        } else {
-            return SCORE_BAD_CAPTURE + see_score; // Bad captures sorted by SEE
-        }
-    }
-    
-    // Killer moves
-    if (move == killer_moves[ply][0]) return SCORE_KILLER_1;
-    if (move == killer_moves[ply][1]) return SCORE_KILLER_2;
-    
-    // Castling
-    if (flag == CASTLE_KINGSIDE || flag == CASTLE_QUEENSIDE) {
-        return SCORE_CASTLE;
-    }
-    
-    // Promotions (non-capture)
-    if (flag >= PROMOTE_N && flag <= PROMOTE_Q) {
-        return SCORE_CASTLE + (flag - PROMOTE_N) * 100;
-    }
-    
-    // History heuristic for quiet moves
-    int from = MOVE_FROM(move);
-    int to = MOVE_TO(move);
-    return SCORE_QUIET + history_table[from][to];
-}
-
-// Enhanced move sorting (replaces sort_moves)
-void sort_moves(Position* pos, MoveList* list, int ply, int tt_move, const MagicData* magic) {
-    // Simple selection sort with enhanced scoring
-    for (int i = 0; i < list->count - 1; i++) {
-        int best_idx = i;
-        int best_score = score_move(pos, list->moves[i], ply, tt_move, magic);
-        
-        for (int j = i + 1; j < list->count; j++) {
-            int score = score_move(pos, list->moves[j], ply, tt_move, magic);
-            if (score > best_score) {
-                best_score = score;
-                best_idx = j;
-            }
-        }
-        
-        if (best_idx != i) {
-            int tmp = list->moves[i];
-            list->moves[i] = list->moves[best_idx];
-            list->moves[best_idx] = tmp;
-        }
-    }
+    pos->en_passant = state->en_passant;
+    pos->halfmove_clock = state->halfmove_clock;
+    pos->zobrist_hash = state->zobrist_hash;
 }
 
 // Keep your original move_order_heuristic for compatibility
-int move_order_heuristic(const Position* pos, int move, int ply) {
+int move_order_heuristic(const SearchThread* td, const Position* pos, int move, int ply) {
     int flag = MOVE_FLAG(move);
 
     if (flag == CASTLE_KINGSIDE || flag == CASTLE_QUEENSIDE) {
@@ -166,8 +225,8 @@ int move_order_heuristic(const Position* pos, int move, int ply) {
     }
 
     // Killer moves
-    if (move == killer_moves[ply][0]) return 900000;
-    if (move == killer_moves[ply][1]) return 800000;
+    if (move == td->killer_moves[ply][0]) return 900000;
+    if (move == td->killer_moves[ply][1]) return 800000;
 
     if (flag == CAPTURE || flag == PROMOTE_N_CAPTURE || flag == PROMOTE_B_CAPTURE || flag == PROMOTE_R_CAPTURE || flag == PROMOTE_Q_CAPTURE) {
         int from = MOVE_FROM(move);
@@ -180,7 +239,7 @@ int move_order_heuristic(const Position* pos, int move, int ply) {
     // Quiet move: history heuristic
     int from = MOVE_FROM(move);
     int to = MOVE_TO(move);
-    return history_table[from][to];
+    return td->history_table[from][to];
 }
 
 int see(const Position* pos, int move, const MagicData* magic) {
@@ -262,69 +321,38 @@ int get_lmr_reduction(int depth, int move_count, int is_pv, int is_capture, int
     return reduction;
 }
 
-int quiescence(Position* pos, int alpha, int beta, const EvalParams* params, const MagicData* magic, ZobristKeys* keys) {
-    int stand_pat = evaluation(pos, params, magic);
+int quiescence(SearchThread* td, Position* pos, int alpha, int beta, const EvalParams* params, const MagicData* magic, const ZobristKeys* keys) {
+    if (search_is_stopped()) return 0;
+    check_search_limits(td, count_node(td));
+    STATS_INC(td, qnodes);
+
+    int stand_pat = cached_evaluation(td, pos, params, magic);
 
     if (stand_pat >= beta)
         return beta;  // fail-hard beta cutoff
     if (stand_pat > alpha)
         alpha = stand_pat;
 
-    MoveList captures;
-    generate_legal_moves(pos, &captures, pos->side_to_move, magic, keys);
-
-    // Filter to only captures (and optionally promotions)
-    int count = 0;
-    for (int i = 0; i < captures.count; i++) {
-        int flag = MOVE_FLAG(captures.moves[i]);
-        if (flag == CAPTURE ||
-            (flag >= PROMOTE_N_CAPTURE && flag <= PROMOTE_Q_CAPTURE)) {
-            captures.moves[count++] = captures.moves[i];  // keep
-        }
-    }
-    captures.count = count;
-
-    // Order captures using MVV-LVA
-    for (int i = 0; i < captures.count - 1; i++) {
-        for (int j = i + 1; j < captures.count; j++) {
-            int m1 = captures.moves[i], m2 = captures.moves[j];
-
-            int from1 = MOVE_FROM(m1), to1 = MOVE_TO(m1);
-            int from2 = MOVE_FROM(m2), to2 = MOVE_TO(m2);
-            int att1 = get_piece_on_square(pos, from1), cap1 = get_piece_on_square(pos, to1);
-            int att2 = get_piece_on_square(pos, from2), cap2 = get_piece_on_square(pos, to2);
-
-            int score1 = piece_values[cap1 % 6] * 10 - piece_values[att1 % 6];
-            int score2 = piece_values[cap2 % 6] * 10 - piece_values[att2 % 6];
-
-            if (score2 > score1) {
-                int tmp = captures.moves[i];
-                captures.moves[i] = captures.moves[j];
-                captures.moves[j] = tmp;
-            }
-        }
-    }
+    // Captures and queen promotions come out of the picker in MVV-LVA order, losing captures are skipped
+    MovePicker picker;
+    init_qsearch_picker(&picker, pos, magic, keys);
 
     MoveState state;
-    for (int i = 0; i < captures.count; i++) {
-        int move = captures.moves[i];
-
-        // Delta pruning
-        int to = MOVE_TO(move);
-        int captured = get_piece_on_square(pos, to);
-        if (stand_pat + piece_values[captured % 6] + 100 < alpha) {
-            continue;
-        }
-
-        // SEE filtering: skip losing captures
-        if (see(pos, move, magic) < 0) {
+    int move;
+    while ((move = next_move(&picker)) != 0) {
+        // Delta pruning: even winning the victim (and promoting) can't lift the score to alpha
+        int flag = MOVE_FLAG(move);
+        int captured = (flag == EN_PASSANT) ? P : get_piece_on_square(pos, MOVE_TO(move));
+        int gain = (captured >= 0) ? piece_values[captured % 6] : 0;
+        if (flag == PROMOTE_Q || flag == PROMOTE_Q_CAPTURE) gain += piece_values[Q] - piece_values[P];
+        if (stand_pat + gain + 100 < alpha) {
             continue;
         }
 
         if (!make_move(pos, &state, move, keys))
             continue;
 
-        int score = -quiescence(pos, -beta, -alpha, params, magic, keys);
+        int score = -quiescence(td, pos, -beta, -alpha, params, magic, keys);
 
         unmake_move(pos, &state, keys);
 
@@ -337,33 +365,76 @@ int quiescence(Position* pos, int alpha, int beta, const EvalParams* params, con
     return alpha;
 }
 
+// A new best move at this ply: the line becomes the move followed by the child's line
+static inline void update_pv(SearchThread* td, int ply, int move) {
+    int child_length = (ply + 1 < MAX_PLY) ? td->pv_length[ply + 1] : 0;
+    if (ply + 1 + child_length > MAX_PLY) child_length = MAX_PLY - ply - 1;
+
+    td->pv_table[ply][0] = move;
+    for (int i = 0; i < child_length; i++) {
+        td->pv_table[ply][i + 1] = td->pv_table[ply + 1][i];
+    }
+    td->pv_length[ply] = child_length + 1;
+}
+
+// Move of the previous iteration's PV at this ply, as long as the current line still follows it
+static int pv_move_hint(const SearchThread* td, int ply) {
+    if (ply >= td->best_pv_length) return 0;
+    for (int i = 0; i < ply; i++) {
+        if (td->move_stack[i] != td->best_pv[i]) return 0;
+    }
+    return td->best_pv[ply];
+}
+
 // Enhanced search function with PVS and improved pruning
-int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_node, const EvalParams* params, const MagicData* magic, ZobristKeys* keys) {
+int search(SearchThread* td, Position* pos, int depth, int ply, int alpha, int beta, int is_pv_node, const EvalParams* params, const MagicData* magic, const ZobristKeys* keys) {
+    td->pv_length[ply] = 0;
+    if (search_is_stopped()) return 0;
+    check_search_limits(td, count_node(td));
+
+    // The per-ply tables are bounded, so very long check sequences are cut off with a static evaluation
+    if (ply >= MAX_PLY - 1 || td->repetition_index >= MAX_REP_HISTORY)
+        return cached_evaluation(td, pos, params, magic);
+
     int original_alpha = alpha;
     int best_move = 0;
     int stand_pat = 0;
 
-    // Push zobrist hash to repetition stack
-    int old_index = repetition_index;
-    repetition_table[repetition_index++] = pos->zobrist_hash;
-
     // Repetition draw check
-    if (is_threefold_repetition(pos->zobrist_hash)) {
-        repetition_index = old_index;  // Undo Zobrist push before returning
-        return DRAW_PENALTY;  // Avoid repetition in winning positions
+    if (is_repetition(td, pos, ply)) {
+        return DRAW_SCORE;
+    }
+
+    // When the side to move can force a repetition, the node is worth at least a draw
+    if (alpha < DRAW_SCORE && has_upcoming_cycle(td, pos, ply)) {
+        alpha = DRAW_SCORE;
+        if (alpha >= beta) return alpha;
+        original_alpha = alpha;
     }
 
+    // Push zobrist hash to repetition stack
+    int old_index = td->repetition_index;
+    td->repetition_table[td->repetition_index++] = pos->zobrist_hash;
+
     // TT PROBE
     int tt_score;
-    if (tt_probe(pos->zobrist_hash, depth, alpha, beta, &tt_score, &best_move)) {
-        repetition_index = old_index;  // Undo stack push
+    int tt_eval = TT_EVAL_NONE;
+    TTProbe probe = tt_probe(pos->zobrist_hash, depth, alpha, beta, &tt_score, &best_move, &tt_eval);
+    STATS_INC(td, tt_probes);
+    if (probe != TT_PROBE_MISS) STATS_INC(td, tt_hits);
+    if (probe == TT_PROBE_CUTOFF) {
+        STATS_INC(td, tt_cutoffs);
+        td->repetition_index = old_index;  // Undo stack push
         return tt_score;
     }
 
+    // Without a hash move, the previous iteration's PV still gives the expected best move
+    if (!best_move && is_pv_node) best_move = pv_move_hint(td, ply);
+
     // Leaf node → Quiescence
     if (depth == 0) {
-        repetition_index = old_index;
-        return quiescence(pos, alpha, beta, params, magic, keys);
+        td->repetition_index = old_index;
+        return quiescence(td, pos, alpha, beta, params, magic, keys);
     }
 
     // Check extension
@@ -372,13 +443,20 @@ int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_nod
         depth++; // Extend search when in check
     }
 
+    // Static evaluation for the pruning decisions below, taken from the TT entry when it has one
+    int static_eval = TT_EVAL_NONE;
+    if (!in_check) {
+        static_eval = (tt_eval != TT_EVAL_NONE) ? tt_eval : cached_evaluation(td, pos, params, magic);
+    }
+
     // Razoring - if we're way behind even after capturing something, drop to qsearch
     if (!is_pv_node && depth <= 3 && !in_check) {
-        int eval = evaluation(pos, params, magic);
+        int eval = static_eval;
         if (eval + razor_margin[depth] <= alpha) {
-            int razor_score = quiescence(pos, alpha, beta, params, magic, keys);
+            int razor_score = quiescence(td, pos, alpha, beta, params, magic, keys);
             if (razor_score <= alpha) {
-                repetition_index = old_index;
+                STATS_INC(td, razor_cutoffs);
+                td->repetition_index = old_index;
                 return razor_score;
             }
         }
@@ -386,20 +464,25 @@ int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_nod
 
     // Reverse Futility Pruning (Static Null Move Pruning)
     if (!is_pv_node && depth <= 3 && !in_check) {
-        int eval = evaluation(pos, params, magic);
+        int eval = static_eval;
         if (eval - reverse_futility_margin[depth] >= beta) {
-            repetition_index = old_index;
+            STATS_INC(td, reverse_futility_cutoffs);
+            td->repetition_index = old_index;
             return eval; // Fail soft
         }
     }
 
     // Null Move Pruning
     if (!is_pv_node && depth >= 3 && !in_check) {
-        make_null_move(pos, keys);
-        int score = -search(pos, depth - 3, ply + 1, -beta, -beta + 1, 0, params, magic, keys); // null reduction = 2
-        unmake_null_move(pos, keys);
+        STATS_INC(td, null_tries);
+        MoveState null_state;
+        make_null_move(pos, &null_state, keys);
+        td->move_stack[ply] = 0;
+        int score = -search(td, pos, depth - 3, ply + 1, -beta, -beta + 1, 0, params, magic, keys); // null reduction = 2
+        unmake_null_move(pos, &null_state);
         if (score >= beta) {
-            repetition_index = old_index;
+            STATS_INC(td, null_cutoffs);
+            td->repetition_index = old_index;
             return beta;
         }
     }
@@ -407,29 +490,26 @@ int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_nod
     // Extended futility pruning setup
     int can_futility_prune = 0;
     if (!is_pv_node && depth <= 3 && !in_check) {
-        stand_pat = evaluation(pos, params, magic);
+        stand_pat = static_eval;
         can_futility_prune = 1;
     }
 
-    // Generate and order moves
-    MoveList list;
-    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+    // The counter move is the quiet move that last refuted the opponent's previous move
+    int prev_move = (ply > 0) ? td->move_stack[ply - 1] : 0;
+    int counter_move = prev_move ? td->counter_moves[MOVE_FROM(prev_move)][MOVE_TO(prev_move)] : 0;
 
-    // Use enhanced move ordering
-    sort_moves(pos, &list, ply, best_move, magic);
-
-    // Check for mate/stalemate
-    if (list.count == 0) {
-        repetition_index = old_index;
-        return in_check ? -MATE_SCORE + ply : DRAW_SCORE;
-    }
+    // Moves are generated and ordered lazily, stage by stage
+    MovePicker picker;
+    init_move_picker(&picker, td, pos, ply, best_move, counter_move, magic, keys);
 
     int best_score = -MATE_SCORE;
     MoveState state;
     int found_pv = 0;
+    int move_count = 0; // Moves handed out by the picker, pruned ones included
+    int move;
 
-    for (int i = 0; i < list.count; i++) {
-        int move = list.moves[i];
+    while ((move = next_move(&picker)) != 0) {
+        int i = move_count++;
         int flag = MOVE_FLAG(move);
         int is_capture = (flag == CAPTURE ||
                           flag == PROMOTE_N_CAPTURE || flag == PROMOTE_B_CAPTURE ||
@@ -440,11 +520,13 @@ int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_nod
             int margin = futility_margin[depth];  // Make sure this is tuned properly
             if (stand_pat + margin <= alpha) {
                 // Skip this quiet move
+                STATS_INC(td, futility_pruned);
                 continue;
             }
         }
 
         if (!make_move(pos, &state, move, keys)) continue;
+        td->move_stack[ply] = move;
 
         int score;
         int gives_check = is_in_check(pos, pos->side_to_move, magic);
@@ -454,26 +536,34 @@ int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_nod
             if (depth >= 3 && i >= 3 && !is_capture && !gives_check) {
                 // LMR
                 int reduction = get_lmr_reduction(depth, i, is_pv_node, is_capture, gives_check);
-                score = -search(pos, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, 0, params, magic, keys);
+                STATS_INC(td, lmr_searches);
+                score = -search(td, pos, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, 0, params, magic, keys);
 
                 if (score > alpha) {
-                    score = -search(pos, depth - 1, ply + 1, -beta, -alpha, 1, params, magic, keys);
+                    STATS_INC(td, lmr_researches);
+                    score = -search(td, pos, depth - 1, ply + 1, -beta, -alpha, 1, params, magic, keys);
                 }
             } else {
-                score = -search(pos, depth - 1, ply + 1, -beta, -alpha, 1, params, magic, keys);
+                score = -search(td, pos, depth - 1, ply + 1, -beta, -alpha, 1, params, magic, keys);
             }
         } else {
             // PVS: Try null window first
-            score = -search(pos, depth - 1, ply + 1, -alpha - 1, -alpha, 0, params, magic, keys);
+            score = -search(td, pos, depth - 1, ply + 1, -alpha - 1, -alpha, 0, params, magic, keys);
 
             // Re-search if it fails high
             if (score > alpha && score < beta) {
-                score = -search(pos, depth - 1, ply + 1, -beta, -alpha, 1, params, magic, keys);
+                score = -search(td, pos, depth - 1, ply + 1, -beta, -alpha, 1, params, magic, keys);
             }
         }
 
         unmake_move(pos, &state, keys);
 
+        // An interrupted child returns a meaningless score, so leave without touching the TT
+        if (search_is_stopped()) {
+            td->repetition_index = old_index;
+            return 0;
+        }
+
         if (score > best_score) {
             best_score = score;
             best_move = move;
@@ -482,19 +572,27 @@ int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_nod
         if (score > alpha) {
             alpha = score;
             found_pv = 1;
+            if (is_pv_node) update_pv(td, ply, move);
         }
 
         if (alpha >= beta) {
+            STATS_INC(td, fail_highs);
+            if (i == 0) STATS_INC(td, first_move_fail_highs);
+
             // History and Killer Heuristics
             int from = MOVE_FROM(move);
             int to   = MOVE_TO(move);
 
-            if (!is_capture) {
-                history_table[from][to] += depth * depth;
+            if (!move_is_noisy(move)) {
+                td->history_table[from][to] += depth * depth;
 
-                if (killer_moves[ply][0] != move) {
-                    killer_moves[ply][1] = killer_moves[ply][0];
-                    killer_moves[ply][0] = move;
+                if (td->killer_moves[ply][0] != move) {
+                    td->killer_moves[ply][1] = td->killer_moves[ply][0];
+                    td->killer_moves[ply][0] = move;
+                }
+
+                if (prev_move) {
+                    td->counter_moves[MOVE_FROM(prev_move)][MOVE_TO(prev_move)] = move;
                 }
             }
 
@@ -502,127 +600,338 @@ int search(Position* pos, int depth, int ply, int alpha, int beta, int is_pv_nod
         }
     }
 
+    // No legal move: mate or stalemate
+    if (move_count == 0) {
+        td->repetition_index = old_index;
+        return in_check ? -MATE_SCORE + ply : DRAW_SCORE;
+    }
+
     // Store in TT
     TTFlag flag = (best_score <= original_alpha) ? TT_ALPHA :
                   (best_score >= beta)           ? TT_BETA :
                                                     TT_EXACT;
-    tt_store(pos->zobrist_hash, depth, best_score, best_move, flag);
+    tt_store(pos->zobrist_hash, depth, best_score, static_eval, best_move, flag);
 
     // Undo repetition stack
-    repetition_index = old_index;
+    td->repetition_index = old_index;
 
     return best_score;
 }
 
-// Enhanced find_best_move with iterative deepening
-int find_best_move(Position* pos, int max_depth, const EvalParams* params,
-                   const MagicData* magic, ZobristKeys* keys,
-                   int* mate_line, int* mate_length) {
-    for (int i = 0; i < MAX_PLY; i++) {
-        killer_moves[i][0] = 0;
-        killer_moves[i][1] = 0;
-    }
-    for (int from = 0; from < 64; from++) {
-        for (int to = 0; to < 64; to++) {
-            history_table[from][to] = 0;
-            counter_moves[from][to] = 0;
+#ifdef SEARCH_STATS
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+// Counters of the main thread, cumulative over the iterations of the current search
+static void print_search_stats(const SearchThread* td) {
+    const SearchStats* s = &td->stats;
+    uint64_t nodes = atomic_load_explicit(&td->nodes, memory_order_relaxed);
+    printf("info string stats nodes %llu qnodes %llu (%.1f%%) tt probes %llu hits %llu (%.1f%%) cutoffs %llu (%.1f%%)\n",
+           (unsigned long long)nodes, (unsigned long long)s->qnodes, percent(s->qnodes, nodes),
+           (unsigned long long)s->tt_probes, (unsigned long long)s->tt_hits, percent(s->tt_hits, s->tt_probes),
+           (unsigned long long)s->tt_cutoffs, percent(s->tt_cutoffs, s->tt_probes));
+    printf("info string stats failhigh %llu first %.1f%% null %llu cutoffs %llu (%.1f%%) razor %llu rfp %llu futility %llu "
+           "lmr %llu researches %llu (%.1f%%)\n",
+           (unsigned long long)s->fail_highs, percent(s->first_move_fail_highs, s->fail_highs),
+           (unsigned long long)s->null_tries, (unsigned long long)s->null_cutoffs, percent(s->null_cutoffs, s->null_tries),
+           (unsigned long long)s->razor_cutoffs, (unsigned long long)s->reverse_futility_cutoffs,
+           (unsigned long long)s->futility_pruned, (unsigned long long)s->lmr_searches,
+           (unsigned long long)s->lmr_researches, percent(s->lmr_researches, s->lmr_searches));
+    printf("info string stats aspiration faillow %llu failhigh %llu\n",
+           (unsigned long long)s->aspiration_fail_lows, (unsigned long long)s->aspiration_fail_highs);
+}
+#endif
+
+// Hash cutoffs cut the triangular PV short, so a mating line is completed from the TT moves
+// until it reaches the mate. Every move is checked for legality before it is appended.
+static void extend_mate_pv(SearchThread* td, int mate_plies) {
+    if (mate_plies > MAX_PLY) mate_plies = MAX_PLY;
+
+    Position pos = td->pos;
+    MoveState state;
+    for (int i = 0; i < td->best_pv_length; i++) {
+        if (!make_move(&pos, &state, td->best_pv[i], td->keys)) return;
+    }
+
+    while (td->best_pv_length < mate_plies) {
+        int score, move = 0, eval;
+        tt_probe(pos.zobrist_hash, MAX_PLY, -MATE_SCORE, MATE_SCORE, &score, &move, &eval);
+        if (!move) return;
+
+        MoveList list;
+        generate_legal_moves(&pos, &list, pos.side_to_move, td->magic, td->keys);
+        int legal = 0;
+        for (int i = 0; i < list.count; i++) {
+            if (list.moves[i] == move) legal = 1;
         }
+        if (!legal || !make_move(&pos, &state, move, td->keys)) return;
+
+        td->best_pv[td->best_pv_length++] = move;
+    }
+}
+
+// Writes the PV of the last completed iteration as " e2e4 e7e5 ..."
+static void format_pv(const SearchThread* td, char* out) {
+    char* p = out;
+    for (int i = 0; i < td->best_pv_length; i++) {
+        char move_str[6];
+        move_to_uci(td->best_pv[i], move_str);
+        p += sprintf(p, " %s", move_str);
     }
+    *p = '\0';
+}
 
+// Searches all root moves within (alpha, beta) and returns the best score, fail soft. A move that
+// raises alpha is moved to the front of the list, so the best move so far and a move that failed
+// high are searched first in the next pass. Returns as soon as a move fails high.
+static int search_root(SearchThread* td, MoveList* list, int depth, int alpha, int beta, int* best_move) {
+    Position* pos = &td->pos;
+    MoveState state;
+    int best_score = -MATE_SCORE;
+    *best_move = 0;
+    td->pv_length[0] = 0;
+
+    for (int i = 0; i < list->count; i++) {
+        int move = list->moves[i];
+        if (!make_move(pos, &state, move, td->keys)) continue;
+        td->move_stack[0] = move;
+
+        int score;
+        if (i == 0) {
+            score = -search(td, pos, depth - 1, 1, -beta, -alpha, 1, td->params, td->magic, td->keys);
+        } else {
+            score = -search(td, pos, depth - 1, 1, -alpha - 1, -alpha, 0, td->params, td->magic, td->keys);
+            if (score > alpha && score < beta) {
+                score = -search(td, pos, depth - 1, 1, -beta, -alpha, 1, td->params, td->magic, td->keys);
+            }
+        }
+
+        unmake_move(pos, &state, td->keys);
+        if (search_is_stopped()) return best_score;
+
+        if (score > best_score) {
+            best_score = score;
+        }
+
+        if (score > alpha) {
+            alpha = score;
+            *best_move = move;
+            update_pv(td, 0, move);
+
+            // Keep the order of the other moves, which is roughly the order of their last scores
+            for (int j = i; j > 0; j--) list->moves[j] = list->moves[j - 1];
+            list->moves[0] = move;
+
+            if (score >= beta) break;
+        }
+    }
+
+    return best_score;
+}
+
+// Iterative deepening driver run by every search thread; only the main thread reports progress
+static void iterative_deepening(SearchThread* td) {
+    Position* pos = &td->pos;
     MoveList list;
-    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+    generate_legal_moves(pos, &list, pos->side_to_move, td->magic, td->keys);
 
     if (list.count == 0) {
-        return 0;
+        return;
     }
 
     int best_move = 0;
     int best_score = -MATE_SCORE;
 
-    for (int depth = 1; depth <= max_depth; depth++) {
+    // Helpers with an odd id start one ply deeper so that the threads spread over neighbouring depths
+    int start_depth = (td->id & 1) ? 2 : 1;
+
+    for (int depth = start_depth; depth <= td->max_depth; depth++) {
         int current_best_move = 0;
         int current_best_score = -MATE_SCORE;
-        MoveState state;
 
+        // Aspiration windows: search a narrow window around the previous score and widen it
+        // exponentially on the side that failed, until the score lands inside
+        int delta = ASPIRATION_WINDOW;
         int alpha = -MATE_SCORE;
         int beta = MATE_SCORE;
+        if (depth >= ASPIRATION_MIN_DEPTH && abs(best_score) < MATE_SCORE - 1000) {
+            alpha = MAX(best_score - delta, -MATE_SCORE);
+            beta = MIN(best_score + delta, MATE_SCORE);
+        }
+
+        while (1) {
+            int move = 0;
+            int score = search_root(td, &list, depth, alpha, beta, &move);
+            if (search_is_stopped()) break;
+
+            if (score <= alpha && alpha > -MATE_SCORE) {
+                // Fail low: the best move is unknown, pull beta in and search again below
+                STATS_INC(td, aspiration_fail_lows);
+                beta = (alpha + beta) / 2;
+                alpha = MAX(score - delta, -MATE_SCORE);
+            } else if (score >= beta && beta < MATE_SCORE) {
+                // Fail high: the refuting move is already at the front of the root list
+                STATS_INC(td, aspiration_fail_highs);
+                beta = MIN(score + delta, MATE_SCORE);
+            } else {
+                current_best_move = move;
+                current_best_score = score;
+                break;
+            }
 
-        if (depth > 2 && abs(best_score) < MATE_SCORE - 1000) {
-            alpha = best_score - 50;
-            beta = best_score + 50;
+            delta += delta;
+            if (delta > ASPIRATION_MAX_WINDOW) {
+                alpha = -MATE_SCORE;
+                beta = MATE_SCORE;
+            }
         }
 
-        bool research = true;
-        int research_count = 0;
+        // A partially searched iteration is discarded
+        if (search_is_stopped()) break;
 
-        while (research && research_count < 3) {
-            research = false;
+        if (current_best_move != 0) {
+            best_move = current_best_move;
+            best_score = current_best_score;
+            td->best_move = best_move;
+            td->best_score = best_score;
+            td->completed_depth = depth;
 
-            // printf("info string Total legal moves: %d\n", list.count);
-            for (int i = 0; i < list.count; i++) {
-                // char san[7];
-                // move_to_san(pos, list.moves[i], san, magic, keys);
-                // printf("Move %d: %s\n", i, san);
-                int move = list.moves[i];
+            memcpy(td->best_pv, td->pv_table[0], sizeof(int) * td->pv_length[0]);
+            td->best_pv_length = td->pv_length[0];
+            if (abs(best_score) > MATE_SCORE - 1000) extend_mate_pv(td, MATE_SCORE - abs(best_score));
+        }
 
-                if (depth > 1 && move == best_move) {
-                    int tmp = list.moves[0];
-                    list.moves[0] = move;
-                    list.moves[i] = tmp;
-                }
+        if (td->id == 0) {
+            int64_t elapsed = time_now_ms() - search_start_ms;
+            uint64_t nodes = total_search_nodes();
+            // nps from the same elapsed time that is printed, 0 until a millisecond has passed
+            uint64_t nps = (elapsed > 0) ? nodes * 1000 / (uint64_t)elapsed : 0;
+            char pv[MAX_PLY * 6 + 1];
+            format_pv(td, pv);
+            printf("info depth %d score cp %d time %lld nodes %llu nps %llu hashfull %d pv%s\n", depth,
+                   (pos->side_to_move == WHITE) ? best_score : -best_score, (long long)elapsed,
+                   (unsigned long long)nodes, (unsigned long long)nps,
+                   tt_hashfull(), pv);
+#ifdef SEARCH_STATS
+            print_search_stats(td);
+#endif
+            fflush(stdout);
+        }
 
-                if (!make_move(pos, &state, move, keys)) continue;
+        if (abs(best_score) > MATE_SCORE - 1000) {
+            if (td->id == 0) {
+                printf("info string Found mate in %d\n", (MATE_SCORE - abs(best_score) + 1) / 2);
+            }
+            return;  // Forced mate detected
+        }
 
-                int score;
-                if (i == 0) {
-                    score = -search(pos, depth - 1, 1, -beta, -alpha, 1, params, magic, keys);
-                } else {
-                    score = -search(pos, depth - 1, 1, -alpha - 1, -alpha, 0, params, magic, keys);
-                    if (score > alpha && score < beta) {
-                        score = -search(pos, depth - 1, 1, -beta, -alpha, 1, params, magic, keys);
-                    }
-                }
+        // No new iteration is started once the soft time limit has passed
+        if (td->id == 0 && !search_is_pondering() && time_soft_exceeded(td->time)) break;
+    }
+}
 
-                unmake_move(pos, &state, keys);
+static void* helper_thread_main(void* arg) {
+    iterative_deepening((SearchThread*)arg);
+    return NULL;
+}
 
-                if (score > current_best_score) {
-                    current_best_score = score;
-                    current_best_move = move;
-                }
+// Lazy SMP: the main thread runs the regular iterative deepening while the helpers search the
+// same root independently and only communicate through the shared transposition table
+int find_best_move(Position* pos, int max_depth, const TimeManager* time, const GameHistory* history, const EvalParams* params,
+                   const MagicData* magic, const ZobristKeys* keys,
+                   int* pv_line, int* pv_length) {
+    last_search_nodes = 0;
+    last_search_score = 0;
 
-                if (score > alpha) alpha = score;
+    // Material and PST of params have to be in the tables the accumulators are built from
+    use_psq_tables(params);
+    refresh_psq_state(pos);
+    search_start_ms = time_now_ms();
 
-                if (score <= alpha - 50 || score >= beta + 50) {
-                    research = true;
-                    alpha = -MATE_SCORE;
-                    beta = MATE_SCORE;
-                    break;
-                }
-            }
-            research_count++;
+    MoveList list;
+    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+
+    if (list.count == 0) {
+        return 0;
+    }
+
+    int thread_count = search_threads;
+    SearchThread* threads = calloc(thread_count, sizeof(SearchThread));
+    if (!threads) {
+        fprintf(stderr, "Failed to allocate search threads\n");
+        return 0;
+    }
+
+    atomic_store(&search_stopped, 0);
+    tt_new_search();
+
+    for (int i = 0; i < thread_count; i++) {
+        SearchThread* td = &threads[i];
+        td->id = i;
+        td->pos = *pos;
+        // Helpers keep going past the requested depth until the main thread is done
+        td->max_depth = (i == 0) ? max_depth : MAX_PLY - 1;
+        td->params = params;
+        td->magic = magic;
+        td->keys = keys;
+        td->time = time;
+
+        // The search path is appended to the game history, the root being its last entry
+        if (history) {
+            memcpy(td->repetition_table, history->keys, sizeof(uint64_t) * history->count);
+            td->repetition_index = history->count;
         }
+        td->repetition_table[td->repetition_index++] = pos->zobrist_hash;
+    }
 
-        if (current_best_move != 0) {
-            best_move = current_best_move;
-            best_score = current_best_score;
+    search_pool = threads;
+    search_pool_size = thread_count;
+
+    int started = 1;
+    for (int i = 1; i < thread_count; i++) {
+        if (pthread_create(&threads[i].handle, NULL, helper_thread_main, &threads[i]) != 0) {
+            fprintf(stderr, "Failed to start search thread %d\n", i);
+            break;
         }
+        started++;
+    }
 
-        printf("info depth %d score cp %d\n", depth, (pos->side_to_move == WHITE) ? best_score : -best_score);
+    iterative_deepening(&threads[0]);
 
-        if (abs(best_score) > MATE_SCORE - 1000) {
-            printf("info string Found mate in %d\n", (MATE_SCORE - abs(best_score) + 1) / 2);
-            if (mate_line && mate_length) {
-                mate_line[0] = best_move;
-                *mate_length = 1;
-            }
-            return 2;  // Forced mate detected
+    atomic_store(&search_stopped, 1);
+    for (int i = 1; i < started; i++) {
+        pthread_join(threads[i].handle, NULL);
+    }
+
+    // Prefer the main thread's move unless a helper completed a deeper iteration
+    SearchThread* best = &threads[0];
+    for (int i = 1; i < started; i++) {
+        if (threads[i].best_move && threads[i].completed_depth > best->completed_depth) {
+            best = &threads[i];
         }
     }
 
-    if (mate_line && mate_length) {
-        mate_line[0] = best_move;
-        *mate_length = 1;
+    int best_move = best->best_move;
+    last_search_score = best->best_score;
+    if (pv_line && pv_length) {
+        memcpy(pv_line, best->best_pv, sizeof(int) * best->best_pv_length);
+        *pv_length = best->best_pv_length;
+    }
+    last_search_nodes = total_search_nodes();
+    search_pool = NULL;
+    search_pool_size = 0;
+    free(threads);
+
+    if (!best_move) {
+        best_move = list.moves[0];
+    }
+
+    // Without a completed iteration the line is just the fallback move
+    if (pv_line && pv_length && (*pv_length == 0 || pv_line[0] != best_move)) {
+        pv_line[0] = best_move;
+        *pv_length = 1;
     }
 
     return best_move;
-}
\ No newline at end of file
+}
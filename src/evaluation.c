@@ -2,6 +2,8 @@
 #include "evaluation.h"
 #include "movegen.h"
 #include "operations.h"
+#include <stdio.h>
+#include <stdlib.h>
 
 void evaluate_passed_pawns(const Position* pos, FeatureCounts* counts, const EvalParams* params, const EvalParamsDouble* dparams, int side, int* mg, int* eg, double* dmg, double* deg) {
     counts->passed_pawn_bonus = 0;
@@ -216,68 +218,49 @@ void evaluate_tropism(const Position* pos, FeatureCounts* counts, const EvalPara
     }
 }
 
-int evaluation(const Position* pos, const EvalParams* params, const MagicData* magic) {
-    FeatureCounts counts;
-    int mg = 0, eg = 0;
-    int phase = 0;
-
-    for (int sq = 0; sq < 64; sq++) {
-        int piece = get_piece_on_square(pos, sq);
-        if (piece == -1) continue;
-
-        int side = (piece < 6) ? WHITE : BLACK;
-        int type = piece % 6;
-        int mirrored_sq = (side == WHITE) ? sq : MIRROR(sq);
-
-        // Use PSTs and values from params
-        int mg_val = params->mg_value[type];
-        int eg_val = params->eg_value[type];
-
-        int mg_pst = 0, eg_pst = 0;
-        switch (type) {
-            case P:
-                mg_pst = params->pawn_pst_mg[mirrored_sq];
-                eg_pst = params->pawn_pst_eg[mirrored_sq];
-                phase += 0;
-                break;
-            case N:
-                mg_pst = params->knight_pst_mg[mirrored_sq];
-                eg_pst = params->knight_pst_eg[mirrored_sq];
-                phase += 1;
-                break;
-            case B:
-                mg_pst = params->bishop_pst_mg[mirrored_sq];
-                eg_pst = params->bishop_pst_eg[mirrored_sq];
-                phase += 1;
-                break;
-            case R:
-                mg_pst = params->rook_pst_mg[mirrored_sq];
-                eg_pst = params->rook_pst_eg[mirrored_sq];
-                phase += 2;
-                break;
-            case Q:
-                mg_pst = params->queen_pst_mg[mirrored_sq];
-                eg_pst = params->queen_pst_eg[mirrored_sq];
-                phase += 4;
-                break;
-            case K:
-                mg_pst = params->king_pst_mg[mirrored_sq];
-                eg_pst = params->king_pst_eg[mirrored_sq];
-                break;
-        }
+// Knights on squares no enemy pawn can ever attack, defended by one of their own pawns
+static void evaluate_knight_outposts_cached(const Position* pos, const PawnEntry* pawns, const EvalParams* params, int side, int* mg, int* eg) {
+    Bitboard knights = pos->pieces[side == WHITE ? WN : BN];
+    int eval_sign = (side == pos->side_to_move) ? +1 : -1;
 
-        int mg_score = mg_val + mg_pst;
-        int eg_score = eg_val + eg_pst;
+    int outposts = count_bits(knights & pawns->attacks[side] & ~pawns->attack_span[side ^ 1]);
+    *mg += eval_sign * outposts * params->knight_outpost_bonus_mg;
+    *eg += eval_sign * outposts * params->knight_outpost_bonus_eg;
+}
 
-        mg += (side == pos->side_to_move) ? mg_score : -mg_score;
-        eg += (side == pos->side_to_move) ? eg_score : -eg_score;
+// Material and PST come from the position's accumulators, which are only consistent with params when
+// the tables were built from them: use_psq_tables(params) before setting up the position.
+// Pawn structure terms come from pawn_table, or are computed on the spot when it is NULL.
+int evaluation(const Position* pos, const EvalParams* params, const MagicData* magic, PawnTable* pawn_table) {
+    FeatureCounts counts;
+    int mg, eg;
+
+    // Material, PST and phase come from the accumulators that make_move() maintains
+#ifdef DEBUG
+    int check_mg, check_eg, check_phase;
+    compute_psq_state(pos, &check_mg, &check_eg, &check_phase);
+    if (check_mg != pos->psq_mg || check_eg != pos->psq_eg || check_phase != pos->phase) {
+        fprintf(stderr, "[evaluation] Incremental state out of sync: mg %d/%d eg %d/%d phase %d/%d\n",
+                pos->psq_mg, check_mg, pos->psq_eg, check_eg, pos->phase, check_phase);
+        abort();
     }
+#endif
+    mg = (pos->side_to_move == WHITE) ? pos->psq_mg : -pos->psq_mg;
+    eg = (pos->side_to_move == WHITE) ? pos->psq_eg : -pos->psq_eg;
+    int phase = pos->phase;
+
+    PawnEntry local_pawns;
+    const PawnEntry* pawns = &local_pawns;
+    if (pawn_table) {
+        pawns = probe_pawn_table(pawn_table, pos, params);
+    } else {
+        evaluate_pawn_structure(pos, params, &local_pawns);
+    }
+    mg += (pos->side_to_move == WHITE) ? pawns->mg : -pawns->mg;
+    eg += (pos->side_to_move == WHITE) ? pawns->eg : -pawns->eg;
 
-    evaluate_passed_pawns(pos, &counts, params, NULL, WHITE, &mg, &eg, NULL, NULL);
-    evaluate_passed_pawns(pos, &counts, params, NULL, BLACK, &mg, &eg, NULL, NULL);
-
-    evaluate_knight_outposts(pos, &counts, params, NULL, WHITE, &mg, &eg, NULL, NULL);
-    evaluate_knight_outposts(pos, &counts, params, NULL, BLACK, &mg, &eg, NULL, NULL);
+    evaluate_knight_outposts_cached(pos, pawns, params, WHITE, &mg, &eg);
+    evaluate_knight_outposts_cached(pos, pawns, params, BLACK, &mg, &eg);
 
     evaluate_rook_activity(pos, &counts, params, NULL, WHITE, &mg, &eg, NULL, NULL);
     evaluate_rook_activity(pos, &counts, params, NULL, BLACK, &mg, &eg, NULL, NULL);
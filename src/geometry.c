@@ -0,0 +1,101 @@
+#include "board.h"
+#include "geometry.h"
+#include <stdlib.h>
+
+Bitboard knight_attack_table[64];
+Bitboard king_attack_table[64];
+Bitboard pawn_attack_table[2][64];
+Bitboard between_table[64][64];
+Bitboard line_table[64][64];
+uint8_t manhattan_table[64][64];
+
+// Shift the square in every knight direction, with file masks to prevent wrap-around
+static Bitboard compute_knight_attacks(int sq) {
+    Bitboard knight = 1ULL << sq;
+    Bitboard attacks = 0;
+
+    attacks |= (knight & ~FILE_X(7)) << 17; // +1 file, +2 ranks
+    attacks |= (knight & ~FILE_X(0)) << 15; // -1 file, +2 ranks
+    attacks |= (knight & ~(FILE_X(7) | FILE_X(6))) << 10; // +2 files, +1 rank
+    attacks |= (knight & ~(FILE_X(0) | FILE_X(1))) << 6; // -2 files, +1 rank
+    attacks |= (knight & ~FILE_X(0)) >> 17; // -1 file, -2 ranks
+    attacks |= (knight & ~FILE_X(7)) >> 15; // +1 file, -2 ranks
+    attacks |= (knight & ~(FILE_X(0) | FILE_X(1))) >> 10; // -2 files, -1 rank
+    attacks |= (knight & ~(FILE_X(7) | FILE_X(6))) >> 6; // +2 files, -1 rank
+
+    return attacks;
+}
+
+static Bitboard compute_king_attacks(int sq) {
+    Bitboard king = 1ULL << sq;
+    Bitboard attacks = 0;
+
+    attacks |= (king & ~FILE_X(0)) << 7; // -1 file, +1 rank
+    attacks |= king << 8; // +1 rank
+    attacks |= (king & ~FILE_X(7)) << 9; // +1 file, +1 rank
+    attacks |= (king & ~FILE_X(7)) << 1; // +1 file
+    attacks |= (king & ~FILE_X(7)) >> 7; // +1 file, -1 rank
+    attacks |= king >> 8; // -1 rank
+    attacks |= (king & ~FILE_X(0)) >> 9; // -1 file, -1 rank
+    attacks |= (king & ~FILE_X(0)) >> 1; // -1 file
+
+    return attacks;
+}
+
+static Bitboard compute_pawn_attacks(int sq, int side) {
+    Bitboard pawn = 1ULL << sq;
+    return (side == WHITE)
+        ? ((pawn & ~FILE_X(0)) << 7) | ((pawn & ~FILE_X(7)) << 9)
+        : ((pawn & ~FILE_X(0)) >> 9) | ((pawn & ~FILE_X(7)) >> 7);
+}
+
+// Walk from a towards b in steps of (df, dr) until b or the edge, returns the squares visited before b
+static Bitboard walk_ray(int a, int b, int df, int dr, int* reached) {
+    Bitboard bb = 0;
+    int f = FILE(a) + df, r = RANK(a) + dr;
+    *reached = 0;
+    while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+        int sq = r * 8 + f;
+        if (sq == b) {
+            *reached = 1;
+            break;
+        }
+        bb |= 1ULL << sq;
+        f += df;
+        r += dr;
+    }
+    return bb;
+}
+
+static void compute_lines(int a, int b) {
+    between_table[a][b] = 0;
+    line_table[a][b] = 0;
+    if (a == b) return;
+
+    int df = FILE(b) - FILE(a), dr = RANK(b) - RANK(a);
+    if (df != 0 && dr != 0 && abs(df) != abs(dr)) return;
+
+    // Unit step from a towards b
+    df = (df > 0) - (df < 0);
+    dr = (dr > 0) - (dr < 0);
+
+    int reached;
+    between_table[a][b] = walk_ray(a, b, df, dr, &reached);
+
+    // The line runs through both squares from one edge of the board to the other
+    line_table[a][b] = walk_ray(a, -1, df, dr, &reached) | walk_ray(a, -1, -df, -dr, &reached) | (1ULL << a);
+}
+
+void init_geometry(void) {
+    for (int sq = 0; sq < 64; sq++) {
+        knight_attack_table[sq] = compute_knight_attacks(sq);
+        king_attack_table[sq] = compute_king_attacks(sq);
+        pawn_attack_table[WHITE][sq] = compute_pawn_attacks(sq, WHITE);
+        pawn_attack_table[BLACK][sq] = compute_pawn_attacks(sq, BLACK);
+
+        for (int other = 0; other < 64; other++) {
+            compute_lines(sq, other);
+            manhattan_table[sq][other] = abs(FILE(sq) - FILE(other)) + abs(RANK(sq) - RANK(other));
+        }
+    }
+}
@@ -1,8 +1,6 @@
 #include "board.h"
 #include "magic.h"
 #include "operations.h"
-#include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
 // Magic numbers from https://github.com/maksimKorzh/chess_programming/blob/master/src/magics/magics.txt
@@ -162,13 +160,24 @@ const int bishop_shifts_const[64] = {
     6, 5, 5, 5, 5, 5, 5, 6
 };
 
-void init_magic(MagicData* magic) {
+// Fills the PEXT tables from the offsets build_magic_tables() laid out, a mask with n bits needs 1 << n slots
+static void init_pext_tables(MagicData* magic) {
+    for (int sq = 0; sq < 64; sq++) {
+        uint64_t rook_limit = 1ULL << count_bits(magic->rook_masks[sq]);
+        for (uint64_t index = 0; index < rook_limit; index++) {
+            Bitboard blockers = set_blockers_from_index(index, magic->rook_masks[sq]);
+            magic->rook_pext_table[magic->rook_offsets[sq] + index] = compute_rook_attacks(sq, blockers);
+        }
 
-    if (load_magic_tables(magic, "magictable.bin")) {
-        // printf("Loaded magic tables from disk.\n");
-        return;
+        uint64_t bishop_limit = 1ULL << count_bits(magic->bishop_masks[sq]);
+        for (uint64_t index = 0; index < bishop_limit; index++) {
+            Bitboard blockers = set_blockers_from_index(index, magic->bishop_masks[sq]);
+            magic->bishop_pext_table[magic->bishop_offsets[sq] + index] = compute_bishop_attacks(sq, blockers);
+        }
     }
-    
+}
+
+void build_magic_tables(MagicData* magic) {
     // printf("init_magic() called\n");
     // memset(magic, 0, sizeof(MagicData)); // or memset(magic->bishop_shifts, 0, sizeof(magic->bishop_shifts));
     memcpy(magic->rook_magics, rook_magics_const, sizeof(rook_magics_const));
@@ -177,57 +186,34 @@ void init_magic(MagicData* magic) {
     memcpy(magic->bishop_shifts, bishop_shifts_const, sizeof(bishop_shifts_const));
     // printf("Global constants defined\n");
 
+    // Each square gets exactly the 1 << shift slots its magic index can reach
+    uint32_t rook_offset = 0, bishop_offset = 0;
     for (int sq = 0; sq < 64; sq++) {
         magic->rook_masks[sq] = mask_rook_blockers(sq);
         magic->bishop_masks[sq] = mask_bishop_blockers(sq);
-        // printf("sq=%2d  bishop_shift=%2d  rook_shift=%2d\n", sq, magic->bishop_shifts[sq], magic->rook_shifts[sq]);
+        magic->rook_offsets[sq] = rook_offset;
+        magic->bishop_offsets[sq] = bishop_offset;
+        rook_offset += 1U << magic->rook_shifts[sq];
+        bishop_offset += 1U << magic->bishop_shifts[sq];
     }
 
-    // printf("Blocker masks initialized\n");
-
     for (int sq = 0; sq < 64; sq++) {
-        int rook_bits = count_bits(magic->rook_masks[sq]);
-        // printf("rook bits counted\n");
-        uint64_t rook_limit = 1ULL << rook_bits;
-        // printf("Square %d rook combos: %llu\n", sq, rook_limit);
-        // fflush(stdout);
+        Bitboard* rook_table = &magic->rook_attack_table[magic->rook_offsets[sq]];
+        uint64_t rook_limit = 1ULL << count_bits(magic->rook_masks[sq]);
         for (uint64_t index = 0; index < rook_limit; index++) {
             Bitboard blockers = set_blockers_from_index(index, magic->rook_masks[sq]);
             uint64_t magic_index = (blockers * magic->rook_magics[sq]) >> (64 - magic->rook_shifts[sq]);
-            magic->rook_attack_table[sq][magic_index] = compute_rook_attacks(sq, blockers);
+            rook_table[magic_index] = compute_rook_attacks(sq, blockers);
         }
 
-        int bishop_bits = count_bits(magic->bishop_masks[sq]);
-        // printf("bishop bits counted\n");
-        uint64_t bishop_limit = 1ULL << bishop_bits;
-        // printf("Square %d bishop combos: %llu\n", sq, bishop_limit);
-        // fflush(stdout);
+        Bitboard* bishop_table = &magic->bishop_attack_table[magic->bishop_offsets[sq]];
+        uint64_t bishop_limit = 1ULL << count_bits(magic->bishop_masks[sq]);
         for (uint64_t index = 0; index < bishop_limit; index++) {
             Bitboard blockers = set_blockers_from_index(index, magic->bishop_masks[sq]);
             uint64_t magic_index = (blockers * magic->bishop_magics[sq]) >> (64 - magic->bishop_shifts[sq]);
-            magic->bishop_attack_table[sq][magic_index] = compute_bishop_attacks(sq, blockers);
+            bishop_table[magic_index] = compute_bishop_attacks(sq, blockers);
         }
-        // printf("init_magic success\n");
     }
 
-    save_magic_tables(magic, "magictable.bin");
-    // printf("Saved magic tables to disk.\n");
-}
-
-int save_magic_tables(const MagicData* magic, const char* path) {
-    FILE* f = fopen(path, "wb");
-    if (!f) return 0;
-
-    size_t written = fwrite(magic, sizeof(MagicData), 1, f);
-    fclose(f);
-    return written == 1;
-}
-
-int load_magic_tables(MagicData* magic, const char* path) {
-    FILE* f = fopen(path, "rb");
-    if (!f) return 0;
-
-    size_t read = fread(magic, sizeof(MagicData), 1, f);
-    fclose(f);
-    return read == 1;
+    init_pext_tables(magic);
 }
\ No newline at end of file
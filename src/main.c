@@ -1,3 +1,4 @@
+#include "bench.h"
 #include "board.h"
 #include "evalsearch.h"
 #include "evaltuner.h"
@@ -6,10 +7,12 @@
 #include "moveformat.h"
 #include "movegen.h"
 #include "operations.h"
+#include "perft.h"
 #include "test.h"
 #include "uci.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // Starting position: rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1
 // Example FEN: 2n1nkn1/1NBPpppP/8/pP1QN1Pp/1P6/2b5/3N4/R3K2R w KQ a6 0 2
@@ -22,19 +25,34 @@
 int depth = 8;
 
 int main(int argc, char** argv) {
-    MagicData* magic = malloc(sizeof(MagicData));
-    if (!magic) {
-        fprintf(stderr, "Failed to allocate MagicData\n");
-        return 1;
+    const MagicData* magic = &magic_data;
+
+    const ZobristKeys* keys = &zobrist_keys;
+
+    init_engine();
+
+    if (argc > 1 && strcmp(argv[1], "selftest") == 0) {
+        int failures = run_self_tests(magic, keys);
+        return failures ? 1 : 0;
+    }
+
+    // bench [depth] [threads] [hash]: fixed search over the built-in positions, prints nodes and nps
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        int bench_depth = (argc > 2) ? atoi(argv[2]) : BENCH_DEFAULT_DEPTH;
+        int threads = (argc > 3) ? atoi(argv[3]) : BENCH_DEFAULT_THREADS;
+        int hash_mb = (argc > 4) ? atoi(argv[4]) : BENCH_DEFAULT_HASH_MB;
+        run_bench(bench_depth, threads, hash_mb, magic, keys);
+        return 0;
     }
 
-    ZobristKeys* keys = malloc(sizeof(ZobristKeys));
-    if (!keys) {
-        fprintf(stderr, "Failed to allocate ZobristKeys\n");
-        return 1;
+    // perft-suite <file.epd> [threads] [max depth]: movegen check and benchmark over an EPD suite
+    if (argc > 2 && strcmp(argv[1], "perft-suite") == 0) {
+        int threads = (argc > 3) ? atoi(argv[3]) : 0;
+        int max_depth = (argc > 4) ? atoi(argv[4]) : 0;
+        int failures = run_perft_suite(argv[2], threads, max_depth, magic, keys);
+        return failures ? 1 : 0;
     }
 
-    init_engine(magic, keys);
     Position pos;
     MoveState state;
     MoveList list;
@@ -67,7 +85,5 @@ int main(int argc, char** argv) {
     // } else {
     //     fprintf(stderr, "Usage: %s <dataset.txt> <output_prefix>\n", argv[0]);
     // }
-    free(magic);
-    free(keys);
     return 0;
 }
\ No newline at end of file
@@ -34,18 +34,12 @@ int encode_move(int from_sq, int to_sq, int move_flag) {
     return (move_flag << 12) | (from_sq << 6) | to_sq ;
 }
 
-void move_to_san(const Position* pos, int move, char* san, const MagicData* magic, ZobristKeys* keys) {
+void move_to_san(const Position* pos, int move, char* san, const MagicData* magic, const ZobristKeys* keys) {
     int from = MOVE_FROM(move);
     int to = MOVE_TO(move);
     int flag = MOVE_FLAG(move);
 
-    int piece_type = -1;
-    for (int p = 0; p < 12; ++p) {
-        if ((pos->pieces[p] >> from) & 1ULL) {
-            piece_type = p;
-            break;
-        }
-    }
+    int piece_type = get_piece_on_square(pos, from);
 
     char from_str[3], to_str[3];
     square_to_coords(from, from_str);
@@ -1,4 +1,5 @@
 #include "board.h"
+#include "evalparams.h"
 #include "magic.h"
 #include "moveformat.h"
 #include "movegen.h"
@@ -27,7 +28,7 @@ int is_in_check(const Position* pos, int side, const MagicData* magic) {
 }
 
 // Is the given side in checkmate?
-int is_in_checkmate(const Position* pos, int side, const MagicData* magic, ZobristKeys* keys) {
+int is_in_checkmate(const Position* pos, int side, const MagicData* magic, const ZobristKeys* keys) {
 
     // Check if the given side is in check: if not, they can't be in checkmate either
     if (!is_in_check(pos, side, magic)) return 0;
@@ -39,7 +40,7 @@ int is_in_checkmate(const Position* pos, int side, const MagicData* magic, Zobri
 }
 
 // Is the given side in stalemate?
-int is_in_stalemate(const Position* pos, int side, const MagicData* magic, ZobristKeys* keys) {
+int is_in_stalemate(const Position* pos, int side, const MagicData* magic, const ZobristKeys* keys) {
 
     // Check if the given side is in check: if yes, they can't be in stalemate
     if (is_in_check(pos, side, magic)) return 0;
@@ -51,7 +52,20 @@ int is_in_stalemate(const Position* pos, int side, const MagicData* magic, Zobri
 }
 
 // Function to make a move
-int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
+// Keep the material + PST sums and the game phase in step with the pieces on the board
+static inline void psq_add(Position* pos, int piece, int sq) {
+    pos->psq_mg += psq_mg[piece][sq];
+    pos->psq_eg += psq_eg[piece][sq];
+    pos->phase += phase_weight[piece % 6];
+}
+
+static inline void psq_remove(Position* pos, int piece, int sq) {
+    pos->psq_mg -= psq_mg[piece][sq];
+    pos->psq_eg -= psq_eg[piece][sq];
+    pos->phase -= phase_weight[piece % 6];
+}
+
+int make_move(Position* pos, MoveState* state, int move, const ZobristKeys* keys) {
 
     // If either the position or state pointers point to nothing, or the encoded move has no value, don't make the move
     if (!pos || !state || move == 0) {
@@ -100,7 +114,12 @@ int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
         .fullmove_number = pos->fullmove_number,
         .promoted_piece = -1,
         .king_sq[WHITE] = pos->king_from[WHITE],
-        .king_sq[BLACK] = pos->king_from[BLACK]
+        .king_sq[BLACK] = pos->king_from[BLACK],
+        .zobrist_hash = pos->zobrist_hash,
+        .pawn_hash = pos->pawn_hash,
+        .psq_mg = pos->psq_mg,
+        .psq_eg = pos->psq_eg,
+        .phase = pos->phase
     };
 
     memcpy(state->rook_from_before, pos->rook_from, sizeof(pos->rook_from));
@@ -111,7 +130,7 @@ int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
     pos->en_passant = -1;
 
     // For 50-move-rule: if a piece was captured or a pawn was moved, reset the halfmove clock
-    if (captured_piece != -1 || (moved_piece & 7) == P)
+    if (captured_piece != -1 || moved_piece % 6 == P)
         pos->halfmove_clock = 0;
     // Otherwise, increment it
     else
@@ -123,8 +142,11 @@ int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
 
     // Remove the moved piece
     pos->zobrist_hash ^= keys->zobrist_pieces[moved_piece][from];
+    psq_remove(pos, moved_piece, from);
+    if (moved_piece == WP || moved_piece == BP) pos->pawn_hash ^= keys->zobrist_pieces[moved_piece][from];
     pos->pieces[moved_piece] &= ~from_bb;
     pos->occupied[side] &= ~from_bb;
+    pos->mailbox[from] = -1;
 
     // Handle capture
     if (captured_piece == WK || captured_piece == BK) {
@@ -134,10 +156,15 @@ int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
         int cap_sq = (side == WHITE) ? to - 8 : to + 8;
         Bitboard cap_bb = 1ULL << cap_sq;
         pos->zobrist_hash ^= keys->zobrist_pieces[captured_piece][cap_sq];
+        psq_remove(pos, captured_piece, cap_sq);
+        pos->pawn_hash ^= keys->zobrist_pieces[captured_piece][cap_sq];
         pos->pieces[captured_piece] &= ~cap_bb;
         pos->occupied[!side] &= ~cap_bb;
+        pos->mailbox[cap_sq] = -1;
     } else if (captured_piece != -1) {
         pos->zobrist_hash ^= keys->zobrist_pieces[captured_piece][to];
+        psq_remove(pos, captured_piece, to);
+        if (captured_piece == WP || captured_piece == BP) pos->pawn_hash ^= keys->zobrist_pieces[captured_piece][to];
         pos->pieces[captured_piece] &= ~to_bb;
         pos->occupied[!side] &= ~to_bb;
     }
@@ -151,14 +178,19 @@ int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
 
         promoted_piece = (side == WHITE ? WN : BN) + promote_index;
         pos->zobrist_hash ^= keys->zobrist_pieces[promoted_piece][to];
+        psq_add(pos, promoted_piece, to);
         pos->pieces[promoted_piece] |= to_bb;
         pos->occupied[side] |= to_bb;
+        pos->mailbox[to] = promoted_piece;
         state->promoted_piece = promoted_piece;
 
     } else {
         pos->zobrist_hash ^= keys->zobrist_pieces[moved_piece][to];
+        psq_add(pos, moved_piece, to);
+        if (moved_piece == WP || moved_piece == BP) pos->pawn_hash ^= keys->zobrist_pieces[moved_piece][to];
         pos->pieces[moved_piece] |= to_bb;
         pos->occupied[side] |= to_bb;
+        pos->mailbox[to] = moved_piece;
     }
 
     // Handle castling
@@ -175,11 +207,16 @@ int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
         pos->zobrist_hash ^= keys->zobrist_pieces[rook][rook_from];
         // XOR rook in at to
         pos->zobrist_hash ^= keys->zobrist_pieces[rook][rook_to];
+        psq_remove(pos, rook, rook_from);
+        psq_add(pos, rook, rook_to);
 
         pos->pieces[rook] &= ~rf_bb;
         pos->pieces[rook] |= rt_bb;
         pos->occupied[side] &= ~rf_bb;
         pos->occupied[side] |= rt_bb;
+        // In Chess960 the king may land on the rook's starting square
+        if (rook_from != to) pos->mailbox[rook_from] = -1;
+        pos->mailbox[rook_to] = rook;
         // Update rook_from[] for castling to reflect that the rook has moved
         pos->rook_from[index] = rook_to;
         // Update castled state
@@ -232,8 +269,9 @@ int make_move(Position* pos, MoveState* state, int move, ZobristKeys* keys) {
     return 1;
 }
 
-int unmake_move(Position* pos, const MoveState* state, ZobristKeys* keys) {
+int unmake_move(Position* pos, const MoveState* state, const ZobristKeys* keys) {
     if (!pos || !state) return 0;
+    (void)keys; // The hash keys are restored from the state rather than updated backwards
 
     int from = state->from;
     int to = state->to;
@@ -252,37 +290,30 @@ int unmake_move(Position* pos, const MoveState* state, ZobristKeys* keys) {
     int captured_piece = state->captured_piece;
     int promoted_piece = state->promoted_piece;
 
-    pos->zobrist_hash ^= keys->zobrist_side;
-
-    if (pos->en_passant != -1)
-        pos->zobrist_hash ^= keys->zobrist_en_passant[pos->en_passant % 8];
-
     pos->side_to_move = side;
     pos->en_passant = state->en_passant;
     pos->castling_rights = state->castling_rights;
     pos->halfmove_clock = state->halfmove_clock;
     pos->fullmove_number = state->fullmove_number;
-
-    if (pos->en_passant != -1)
-        pos->zobrist_hash ^= keys->zobrist_en_passant[pos->en_passant % 8];
-
-    pos->zobrist_hash ^= keys->zobrist_castling[pos->castling_rights];
+    pos->zobrist_hash = state->zobrist_hash;
+    pos->pawn_hash = state->pawn_hash;
+    pos->psq_mg = state->psq_mg;
+    pos->psq_eg = state->psq_eg;
+    pos->phase = state->phase;
 
     // Remove piece from destination
     if (promoted_piece != -1) {
-        pos->zobrist_hash ^= keys->zobrist_pieces[promoted_piece][to];
         pos->pieces[promoted_piece] &= ~to_bb;
     } else {
-        pos->zobrist_hash ^= keys->zobrist_pieces[moved_piece][to];
         pos->pieces[moved_piece] &= ~to_bb;
     }
     pos->occupied[side] &= ~to_bb;
+    pos->mailbox[to] = -1;
 
     // Restore piece to source
     pos->pieces[moved_piece] |= from_bb;
     pos->occupied[side] |= from_bb;
-
-    pos->zobrist_hash ^= keys->zobrist_pieces[moved_piece][from];
+    pos->mailbox[from] = moved_piece;
 
     // Restore king square
     pos->king_from[WHITE] = state->king_sq[WHITE];
@@ -295,11 +326,11 @@ int unmake_move(Position* pos, const MoveState* state, ZobristKeys* keys) {
         Bitboard cap_bb = 1ULL << cap_sq;
         pos->pieces[captured_piece] |= cap_bb;
         pos->occupied[!side] |= cap_bb;
-        pos->zobrist_hash ^= keys->zobrist_pieces[captured_piece][cap_sq];
+        pos->mailbox[cap_sq] = captured_piece;
     } else if (captured_piece != -1) {
         pos->pieces[captured_piece] |= to_bb;
         pos->occupied[!side] |= to_bb;
-        pos->zobrist_hash ^= keys->zobrist_pieces[captured_piece][to];
+        pos->mailbox[to] = captured_piece;
     }
 
     // Undo castling
@@ -314,16 +345,14 @@ int unmake_move(Position* pos, const MoveState* state, ZobristKeys* keys) {
         Bitboard rf_bb = 1ULL << rook_from;
         Bitboard rt_bb = 1ULL << rook_to;
 
-        // XOR rook back out from moved-to square
-        pos->zobrist_hash ^= keys->zobrist_pieces[rook][rook_to];
-        // XOR rook back in at original square
-        pos->zobrist_hash ^= keys->zobrist_pieces[rook][rook_from];
-
         // Move rook back
         pos->pieces[rook] &= ~rt_bb;
         pos->pieces[rook] |= rf_bb;
         pos->occupied[side] &= ~rt_bb;
         pos->occupied[side] |= rf_bb;
+        // In Chess960 the rook may have landed on the king's starting square
+        if (rook_to != from) pos->mailbox[rook_to] = -1;
+        pos->mailbox[rook_from] = rook;
 
         // Restore rook_from[] now
         memcpy(pos->rook_from, state->rook_from_before, sizeof(pos->rook_from));
@@ -340,24 +369,38 @@ int unmake_move(Position* pos, const MoveState* state, ZobristKeys* keys) {
     return 1;
 }
 
-void generate_legal_moves(const Position* pos, MoveList* list, int side, const MagicData* magic, ZobristKeys* keys) {
+// Generate the legal moves of one generation type, given the precomputed checkers and pins
+void generate_moves(const Position* pos, MoveList* list, int side, GenType type, const LegalityInfo* info, const MagicData* magic, const ZobristKeys* keys) {
     if (!pos || !list) return;
 
-    MoveList pseudo = {0};
-    generate_pseudo_legal_moves(pos, &pseudo, side, magic);
-    // printf("Pseudo moves count: %d\n", pseudo.count);
-
-    list->count = 0;
+    // In double check only the king can move
+    if (info->checkers & (info->checkers - 1)) {
+        list->count = 0;
+        generate_king_moves(pos, list, side, type, magic);
+    } else {
+        generate_pseudo_legal_moves(pos, list, side, type, magic);
+    }
+    // printf("Pseudo moves count: %d\n", list->count);
 
-    for (int i = 0; i < pseudo.count; ++i) {
-        int move = pseudo.moves[i];
+    // Filter the list in place
+    int count = 0;
+    for (int i = 0; i < list->count; ++i) {
+        int move = list->moves[i];
 
-        if (is_legal_move(pos, move, magic, keys)) {
-            list->moves[list->count++] = move;
-            // printf("[generate_legal_moves] Legal move: %d\n", move);
-            // printf("Legal move added\n");
-        } // else printf("Illegal move skipped\n");
+        if (is_legal_move_fast(pos, move, info, magic, keys)) {
+            list->moves[count++] = move;
+        }
     }
+    list->count = count;
+
+    // printf("[generate_moves] Total legal moves: %d\n", list->count);
+}
 
-    // printf("[generate_legal_moves] Total legal moves: %d\n", list->count);
-}
\ No newline at end of file
+void generate_legal_moves(const Position* pos, MoveList* list, int side, const MagicData* magic, const ZobristKeys* keys) {
+    if (!pos || !list) return;
+
+    // Checkers and pins are computed once, then each pseudo-legal move is tested against them
+    LegalityInfo info;
+    compute_legality_info(pos, side, &info, magic);
+    generate_moves(pos, list, side, GEN_ALL, &info, magic, keys);
+}
@@ -0,0 +1,220 @@
+#include "board.h"
+#include "evalsearch.h"
+#include "movegen.h"
+#include "movepick.h"
+
+// Quiet move scoring: castling is tried before the history ordered moves, underpromotions last
+#define SCORE_CASTLE          1000000000
+#define SCORE_UNDERPROMOTION -1000000000
+
+void init_move_picker(MovePicker* mp, const SearchThread* td, const Position* pos, int ply,
+                      int tt_move, int counter_move, const MagicData* magic, const ZobristKeys* keys) {
+    mp->td = td;
+    mp->pos = pos;
+    mp->magic = magic;
+    mp->keys = keys;
+    compute_legality_info(pos, pos->side_to_move, &mp->info, magic);
+
+    mp->stage = STAGE_TT_MOVE;
+    mp->tt_move = tt_move;
+    mp->killers[0] = td->killer_moves[ply][0];
+    mp->killers[1] = td->killer_moves[ply][1];
+    mp->counter_move = counter_move;
+
+    mp->special_count = 0;
+
+    mp->moves.count = 0;
+    mp->index = 0;
+    mp->bad_count = 0;
+    mp->bad_index = 0;
+}
+
+void init_qsearch_picker(MovePicker* mp, const Position* pos, const MagicData* magic, const ZobristKeys* keys) {
+    mp->td = NULL;
+    mp->pos = pos;
+    mp->magic = magic;
+    mp->keys = keys;
+    compute_legality_info(pos, pos->side_to_move, &mp->info, magic);
+
+    mp->stage = STAGE_QS_INIT_CAPTURES;
+    mp->tt_move = 0;
+    mp->killers[0] = mp->killers[1] = 0;
+    mp->counter_move = 0;
+    mp->special_count = 0;
+
+    mp->moves.count = 0;
+    mp->index = 0;
+    mp->bad_count = 0;
+    mp->bad_index = 0;
+}
+
+// Moves that come from the heuristics rather than the generator have to be validated first
+static int is_valid_special_move(const MovePicker* mp, int move) {
+    return is_pseudo_legal_move(mp->pos, move, mp->magic) &&
+           is_legal_move_fast(mp->pos, move, &mp->info, mp->magic, mp->keys);
+}
+
+static int is_already_tried(const MovePicker* mp, int move) {
+    if (move == mp->tt_move) return 1;
+    for (int i = 0; i < mp->special_count; i++) {
+        if (mp->specials[i] == move) return 1;
+    }
+    return 0;
+}
+
+// Killers and counter moves are only tried when they are quiet, since noisy moves come from the capture stages anyway
+static int try_quiet_special(MovePicker* mp, int move) {
+    if (move == 0 || move_is_noisy(move) || is_already_tried(mp, move) || !is_valid_special_move(mp, move)) {
+        return 0;
+    }
+    mp->specials[mp->special_count++] = move;
+    return 1;
+}
+
+// MVV-LVA: most valuable victim first, least valuable attacker as the tie break
+static void score_captures(MovePicker* mp) {
+    for (int i = 0; i < mp->moves.count; i++) {
+        int move = mp->moves.moves[i];
+        int flag = MOVE_FLAG(move);
+        int attacker = get_piece_on_square(mp->pos, MOVE_FROM(move)) % 6;
+        int victim = (flag == EN_PASSANT) ? P : get_piece_on_square(mp->pos, MOVE_TO(move));
+
+        int score = (victim >= 0) ? 10 * piece_values[victim % 6] - piece_values[attacker] : 0;
+        if (flag == PROMOTE_Q || flag == PROMOTE_Q_CAPTURE) score += piece_values[Q];
+        mp->scores[i] = score;
+    }
+}
+
+static void score_quiets(MovePicker* mp) {
+    for (int i = 0; i < mp->moves.count; i++) {
+        int move = mp->moves.moves[i];
+        int flag = MOVE_FLAG(move);
+
+        if (flag == CASTLE_KINGSIDE || flag == CASTLE_QUEENSIDE) {
+            mp->scores[i] = SCORE_CASTLE;
+        } else if (flag >= PROMOTE_N && flag <= PROMOTE_R) {
+            mp->scores[i] = SCORE_UNDERPROMOTION + (flag - PROMOTE_N);
+        } else {
+            mp->scores[i] = mp->td->history_table[MOVE_FROM(move)][MOVE_TO(move)];
+        }
+    }
+}
+
+// SEE is only needed when the attacker is worth more than the victim, so most captures skip it
+static int is_losing_capture(const MovePicker* mp, int move) {
+    int victim = get_piece_on_square(mp->pos, MOVE_TO(move));
+    int attacker = get_piece_on_square(mp->pos, MOVE_FROM(move));
+    return victim >= 0 && piece_values[attacker % 6] > piece_values[victim % 6] &&
+           see(mp->pos, move, mp->magic) < 0;
+}
+
+// One step of a selection sort: bring the best remaining move to the front and return it
+static int pick_best(MovePicker* mp) {
+    int best = mp->index;
+    for (int i = mp->index + 1; i < mp->moves.count; i++) {
+        if (mp->scores[i] > mp->scores[best]) best = i;
+    }
+
+    int move = mp->moves.moves[best];
+    mp->moves.moves[best] = mp->moves.moves[mp->index];
+    mp->scores[best] = mp->scores[mp->index];
+    mp->moves.moves[mp->index] = move;
+    mp->index++;
+    return move;
+}
+
+// Returns the next move to search, or 0 when every legal move has been handed out
+int next_move(MovePicker* mp) {
+    while (1) {
+        switch (mp->stage) {
+            case STAGE_TT_MOVE:
+                mp->stage = STAGE_INIT_CAPTURES;
+                if (mp->tt_move && is_valid_special_move(mp, mp->tt_move)) {
+                    return mp->tt_move;
+                }
+                // An unusable hash move must not suppress the same move coming from the generator
+                mp->tt_move = 0;
+                break;
+
+            case STAGE_INIT_CAPTURES:
+                generate_moves(mp->pos, &mp->moves, mp->pos->side_to_move, GEN_NOISY, &mp->info, mp->magic, mp->keys);
+                score_captures(mp);
+                mp->index = 0;
+                mp->stage = STAGE_GOOD_CAPTURES;
+                break;
+
+            case STAGE_GOOD_CAPTURES:
+                while (mp->index < mp->moves.count) {
+                    int move = pick_best(mp);
+                    if (move == mp->tt_move) continue;
+
+                    // Each capture is tested once, the losing ones wait until after the quiet moves
+                    if (is_losing_capture(mp, move)) {
+                        mp->bad_captures[mp->bad_count++] = move;
+                        continue;
+                    }
+                    return move;
+                }
+                mp->stage = STAGE_KILLER_1;
+                break;
+
+            case STAGE_KILLER_1:
+                mp->stage = STAGE_KILLER_2;
+                if (try_quiet_special(mp, mp->killers[0])) return mp->killers[0];
+                break;
+
+            case STAGE_KILLER_2:
+                mp->stage = STAGE_COUNTER_MOVE;
+                if (try_quiet_special(mp, mp->killers[1])) return mp->killers[1];
+                break;
+
+            case STAGE_COUNTER_MOVE:
+                mp->stage = STAGE_INIT_QUIETS;
+                if (try_quiet_special(mp, mp->counter_move)) return mp->counter_move;
+                break;
+
+            case STAGE_INIT_QUIETS:
+                generate_moves(mp->pos, &mp->moves, mp->pos->side_to_move, GEN_QUIET, &mp->info, mp->magic, mp->keys);
+                score_quiets(mp);
+                mp->index = 0;
+                mp->stage = STAGE_QUIETS;
+                break;
+
+            case STAGE_QUIETS:
+                while (mp->index < mp->moves.count) {
+                    int move = pick_best(mp);
+                    if (is_already_tried(mp, move)) continue;
+                    return move;
+                }
+                mp->stage = STAGE_BAD_CAPTURES;
+                break;
+
+            case STAGE_BAD_CAPTURES:
+                if (mp->bad_index < mp->bad_count) {
+                    return mp->bad_captures[mp->bad_index++];
+                }
+                mp->stage = STAGE_DONE;
+                break;
+
+            case STAGE_QS_INIT_CAPTURES:
+                generate_moves(mp->pos, &mp->moves, mp->pos->side_to_move, GEN_NOISY, &mp->info, mp->magic, mp->keys);
+                score_captures(mp);
+                mp->index = 0;
+                mp->stage = STAGE_QS_CAPTURES;
+                break;
+
+            case STAGE_QS_CAPTURES:
+                while (mp->index < mp->moves.count) {
+                    int move = pick_best(mp);
+                    if (is_losing_capture(mp, move)) continue;
+                    return move;
+                }
+                mp->stage = STAGE_DONE;
+                break;
+
+            case STAGE_DONE:
+            default:
+                return 0;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include "board.h"
+#include "operations.h"
+#include "pawnhash.h"
+
+// Fill every square in front of the given ones, from the point of view of side
+static inline Bitboard front_fill(Bitboard bb, int side) {
+    if (side == WHITE) {
+        bb |= bb << 8;
+        bb |= bb << 16;
+        bb |= bb << 32;
+    } else {
+        bb |= bb >> 8;
+        bb |= bb >> 16;
+        bb |= bb >> 32;
+    }
+    return bb;
+}
+
+static inline Bitboard pawn_attacks_bb(Bitboard pawns, int side) {
+    return (side == WHITE)
+        ? ((pawns & ~FILE_X(0)) << 7) | ((pawns & ~FILE_X(7)) << 9)
+        : ((pawns & ~FILE_X(0)) >> 9) | ((pawns & ~FILE_X(7)) >> 7);
+}
+
+void evaluate_pawn_structure(const Position* pos, const EvalParams* params, PawnEntry* entry) {
+    entry->key = pos->pawn_hash;
+    entry->mg = 0;
+    entry->eg = 0;
+
+    for (int side = WHITE; side <= BLACK; side++) {
+        Bitboard pawns = pos->pieces[side == WHITE ? WP : BP];
+        Bitboard enemy_pawns = pos->pieces[side == WHITE ? BP : WP];
+        int sign = (side == WHITE) ? +1 : -1;
+
+        entry->attacks[side] = pawn_attacks_bb(pawns, side);
+        entry->attack_span[side] = front_fill(entry->attacks[side], side);
+        entry->passed[side] = 0;
+
+        // A pawn is passed when no enemy pawn stands in front of it on its own or a neighbouring file
+        Bitboard bb = pawns;
+        while (bb) {
+            int sq = pop_lsb(&bb);
+            Bitboard file_mask = FILE_X(FILE(sq));
+            if (FILE(sq) > 0) file_mask |= FILE_X(FILE(sq - 1));
+            if (FILE(sq) < 7) file_mask |= FILE_X(FILE(sq + 1));
+
+            Bitboard front_mask = SQUARES_AHEAD(sq, side);
+            if (enemy_pawns & file_mask & front_mask) continue;
+
+            entry->passed[side] |= 1ULL << sq;
+            entry->mg += sign * params->passed_pawn_bonus_mg;
+            entry->eg += sign * params->passed_pawn_bonus_eg;
+        }
+    }
+}
+
+const PawnEntry* probe_pawn_table(PawnTable* table, const Position* pos, const EvalParams* params) {
+    // A zeroed entry is also the correct one for key 0, a board without pawns
+    PawnEntry* entry = &table->entries[pos->pawn_hash & (PAWN_TABLE_SIZE - 1)];
+    if (entry->key != pos->pawn_hash) {
+        evaluate_pawn_structure(pos, params, entry);
+    }
+    return entry;
+}
@@ -0,0 +1,259 @@
+#define _POSIX_C_SOURCE 200809L // sysconf under -std=c11
+
+#include "board.h"
+#include "movegen.h"
+#include "perft.h"
+#include "timeman.h"
+#include "uci.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PERFT_DEPTH_BITS 8
+
+int perft_table_init(PerftTable* table, size_t size_mb) {
+    // Largest power of two number of entries that fits into the requested size
+    uint64_t count = 1;
+    while (count * 2 * sizeof(PerftEntry) <= ((uint64_t)size_mb << 20)) count *= 2;
+
+    table->entries = calloc(count, sizeof(PerftEntry));
+    if (!table->entries) {
+        table->mask = 0;
+        fprintf(stderr, "Failed to allocate %zu MB perft hash table\n", size_mb);
+        return 0;
+    }
+    table->mask = count - 1;
+    return 1;
+}
+
+void perft_table_free(PerftTable* table) {
+    free(table->entries);
+    table->entries = NULL;
+    table->mask = 0;
+}
+
+uint64_t perft(Position* pos, int depth, PerftTable* table, const MagicData* magic, const ZobristKeys* keys) {
+    if (depth == 0) return 1;
+
+    MoveList list;
+    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+
+    // Bulk counting: the generator only emits legal moves, so the last ply needs no make_move()
+    if (depth == 1) return (uint64_t)list.count;
+
+    PerftEntry* entry = NULL;
+    if (table && table->entries) {
+        entry = &table->entries[pos->zobrist_hash & table->mask];
+        if (entry->key == pos->zobrist_hash && (int)(entry->data & ((1 << PERFT_DEPTH_BITS) - 1)) == depth) {
+            return entry->data >> PERFT_DEPTH_BITS;
+        }
+    }
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < list.count; i++) {
+        MoveState state;
+        if (!make_move(pos, &state, list.moves[i], keys)) continue;
+        nodes += perft(pos, depth - 1, table, magic, keys);
+        unmake_move(pos, &state, keys);
+    }
+
+    if (entry) {
+        entry->key = pos->zobrist_hash;
+        entry->data = (nodes << PERFT_DEPTH_BITS) | (uint64_t)depth;
+    }
+    return nodes;
+}
+
+uint64_t perft_divide_uci(Position* pos, int depth, PerftTable* table, const MagicData* magic, const ZobristKeys* keys) {
+    if (depth < 1) depth = 1;
+
+    MoveList list;
+    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+
+    uint64_t total = 0;
+    for (int i = 0; i < list.count; i++) {
+        MoveState state;
+        if (!make_move(pos, &state, list.moves[i], keys)) continue;
+        uint64_t count = perft(pos, depth - 1, table, magic, keys);
+        unmake_move(pos, &state, keys);
+
+        char move_str[6];
+        move_to_uci(list.moves[i], move_str);
+        printf("%s: %llu\n", move_str, (unsigned long long)count);
+        total += count;
+    }
+
+    printf("\nNodes searched: %llu\n", (unsigned long long)total);
+    return total;
+}
+
+/* ---------- EPD perft suite ---------- */
+
+typedef struct {
+    Position pos;
+    char fen[256];
+    uint64_t expected[PERFT_SUITE_MAX_DEPTHS + 1]; // Index = depth
+    unsigned has_expected;                         // Bit d set when the EPD gives a count for depth d, which may be 0
+    int max_depth;
+} SuiteEntry;
+
+typedef struct {
+    SuiteEntry* entries;
+    int count;
+    int max_depth;
+    atomic_int next;     // Next entry to hand out
+    atomic_int failures;
+    _Atomic uint64_t nodes;
+    const MagicData* magic;
+    const ZobristKeys* keys;
+} SuiteJob;
+
+// Splits "<fen> ;D1 20 ;D2 400" into the FEN and its expected counts, returns 0 for lines without a FEN
+static int parse_epd_line(char* line, SuiteEntry* entry) {
+    memset(entry->expected, 0, sizeof(entry->expected));
+    entry->has_expected = 0;
+    entry->max_depth = 0;
+
+    char* counts = strchr(line, ';');
+    if (counts) *counts++ = '\0';
+
+    // FEN without trailing blanks, the move counters are optional in EPD but init_position() needs them
+    size_t len = strlen(line);
+    while (len > 0 && isspace((unsigned char)line[len - 1])) line[--len] = '\0';
+    while (*line && isspace((unsigned char)*line)) line++;
+    if (!*line) return 0;
+
+    int fields = 0;
+    for (const char* c = line; *c; c++) {
+        if (!isspace((unsigned char)*c) && (c == line || isspace((unsigned char)c[-1]))) fields++;
+    }
+    snprintf(entry->fen, sizeof(entry->fen), "%s%s", line, (fields < 6) ? " 0 1" : "");
+
+    for (char* field = counts; field; ) {
+        char* next = strchr(field, ';');
+        if (next) *next++ = '\0';
+
+        int depth;
+        unsigned long long nodes;
+        if (sscanf(field, " D%d %llu", &depth, &nodes) == 2 && depth >= 1 && depth <= PERFT_SUITE_MAX_DEPTHS) {
+            entry->expected[depth] = nodes;
+            entry->has_expected |= 1u << depth;
+            if (depth > entry->max_depth) entry->max_depth = depth;
+        }
+        field = next;
+    }
+    return 1;
+}
+
+static void* perft_suite_worker(void* arg) {
+    SuiteJob* job = (SuiteJob*)arg;
+    PerftTable table;
+    int have_table = perft_table_init(&table, PERFT_SUITE_HASH_MB);
+
+    int index;
+    while ((index = atomic_fetch_add(&job->next, 1)) < job->count) {
+        SuiteEntry* entry = &job->entries[index];
+        Position pos = entry->pos;
+        uint64_t nodes = 0;
+        int failed_depth = 0;
+        uint64_t got = 0;
+
+        int64_t start = time_now_ms();
+        for (int depth = 1; depth <= entry->max_depth; depth++) {
+            if (!(entry->has_expected & (1u << depth)) || (job->max_depth > 0 && depth > job->max_depth)) continue;
+            uint64_t count = perft(&pos, depth, have_table ? &table : NULL, job->magic, job->keys);
+            nodes += count;
+            if (count != entry->expected[depth] && !failed_depth) {
+                failed_depth = depth;
+                got = count;
+            }
+        }
+        int64_t elapsed = time_now_ms() - start;
+        atomic_fetch_add(&job->nodes, nodes);
+
+        // One printf per position, so lines from different workers do not interleave
+        if (failed_depth) {
+            atomic_fetch_add(&job->failures, 1);
+            printf("%4d FAIL D%d expected %llu got %llu  %s\n", index + 1, failed_depth,
+                   (unsigned long long)entry->expected[failed_depth], (unsigned long long)got, entry->fen);
+        } else {
+            printf("%4d ok   %12llu nodes %7lld ms %10llu nps  %s\n", index + 1, (unsigned long long)nodes,
+                   (long long)elapsed, (unsigned long long)(nodes * 1000 / (uint64_t)(elapsed > 0 ? elapsed : 1)),
+                   entry->fen);
+        }
+        fflush(stdout);
+    }
+
+    if (have_table) perft_table_free(&table);
+    return NULL;
+}
+
+int run_perft_suite(const char* path, int threads, int max_depth, const MagicData* magic, const ZobristKeys* keys) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open perft suite %s\n", path);
+        return -1;
+    }
+
+    // Positions are set up here, init_position() is not reentrant
+    SuiteJob job = { .max_depth = max_depth, .magic = magic, .keys = keys };
+    int capacity = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        if (job.count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            SuiteEntry* grown = realloc(job.entries, sizeof(SuiteEntry) * capacity);
+            if (!grown) {
+                fprintf(stderr, "Out of memory reading %s\n", path);
+                free(job.entries);
+                fclose(f);
+                return -1;
+            }
+            job.entries = grown;
+        }
+
+        SuiteEntry* entry = &job.entries[job.count];
+        if (!parse_epd_line(line, entry)) continue;
+        init_position(&entry->pos, entry->fen);
+        entry->pos.zobrist_hash = compute_zobrist_hash(&entry->pos, keys);
+        entry->pos.pawn_hash = compute_pawn_hash(&entry->pos, keys);
+        job.count++;
+    }
+    fclose(f);
+
+    if (threads < 1) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > job.count) threads = job.count > 0 ? job.count : 1;
+    printf("perft suite %s: %d positions, %d threads\n", path, job.count, threads);
+
+    pthread_t* handles = malloc(sizeof(pthread_t) * threads);
+    if (!handles) {
+        free(job.entries);
+        return -1;
+    }
+
+    int64_t start = time_now_ms();
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&handles[i], NULL, perft_suite_worker, &job) != 0) break;
+        started++;
+    }
+    // Without any worker the suite still runs, on this thread
+    if (started == 0) perft_suite_worker(&job);
+    for (int i = 0; i < started; i++) pthread_join(handles[i], NULL);
+    int64_t elapsed = time_now_ms() - start;
+
+    uint64_t nodes = atomic_load(&job.nodes);
+    int failures = atomic_load(&job.failures);
+    printf("positions %d, failed %d, nodes %llu, time %lld ms, nps %llu\n", job.count, failures,
+           (unsigned long long)nodes, (long long)elapsed,
+           (unsigned long long)(nodes * 1000 / (uint64_t)(elapsed > 0 ? elapsed : 1)));
+
+    free(handles);
+    free(job.entries);
+    return failures;
+}
@@ -1,10 +1,22 @@
 #include "board.h"
+#include "evalparams.h"
+#include "evalsearch.h"
+#include "evaluation.h"
+#include "geometry.h"
 #include "magic.h"
 #include "moveformat.h"
 #include "movegen.h"
+#include "movepick.h"
+#include "pawnhash.h"
+#include "perft.h"
 #include "test.h"
+#include "tt.h"
+#include "uci.h"
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 // Helper: Check if position is valid (e.g., king exists on board)
 bool is_position_valid(const Position* pos) {
@@ -14,7 +26,7 @@ bool is_position_valid(const Position* pos) {
     return true;
 }
 
-uint64_t perft_debug(Position* pos, int depth, const MagicData* magic, ZobristKeys* keys) {
+uint64_t perft_debug(Position* pos, int depth, const MagicData* magic, const ZobristKeys* keys) {
     if (depth == 0) return 1;
 
     // printf("[DEBUG] Before move - Occupied bitboard:\n");
@@ -98,7 +110,7 @@ uint64_t perft_debug(Position* pos, int depth, const MagicData* magic, ZobristKe
     return nodes;
 }
 
-void perft_divide(Position* pos, int depth, const MagicData* magic, ZobristKeys* keys) {
+void perft_divide(Position* pos, int depth, const MagicData* magic, const ZobristKeys* keys) {
     MoveList list;
     generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
 
@@ -146,4 +158,652 @@ void perft_divide(Position* pos, int depth, const MagicData* magic, ZobristKeys*
     }
 
     printf("Total: %llu\n", total);
-}
\ No newline at end of file
+}
+/* ---------- Transposition table stress test ---------- */
+
+#define TT_STRESS_KEYS (1 << 20)
+
+typedef struct {
+    int id;
+    int iterations;
+    uint64_t hits;
+    uint64_t torn;
+    pthread_t handle;
+} TTStressWorker;
+
+static inline uint64_t stress_mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Every field of a stored entry is derived from its key, so a probe can tell a torn entry apart
+static inline int stress_score(uint64_t key) { return (int)((key >> 16) % 20001) - 10000; }
+static inline int stress_move(uint64_t key) { return (int)((key >> 32) & 0xFFFF) | 1; }
+static inline int stress_depth(uint64_t key) { return (int)((key >> 48) % 64); }
+static inline int stress_eval(uint64_t key) { return (int)(key % 4001) - 2000; }
+
+static void* tt_stress_worker(void* arg) {
+    TTStressWorker* worker = (TTStressWorker*)arg;
+    uint64_t state = stress_mix(worker->id + 1);
+
+    for (int i = 0; i < worker->iterations; i++) {
+        state = stress_mix(state);
+        uint64_t key = stress_mix(state % TT_STRESS_KEYS);
+
+        if (state >> 63) {
+            tt_store(key, stress_depth(key), stress_score(key), stress_eval(key), stress_move(key), TT_EXACT);
+        } else {
+            int score = 0, move = 0, eval = 0;
+            if (tt_probe(key, 0, -MATE_SCORE, MATE_SCORE, &score, &move, &eval) == TT_PROBE_CUTOFF) {
+                worker->hits++;
+                if (score != stress_score(key) || move != stress_move(key) || eval != stress_eval(key)) worker->torn++;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Hammers a deliberately small table from several threads at once, so that stores to the same
+// slots constantly interleave with probes, and returns the number of inconsistent entries seen
+uint64_t tt_stress_test(int thread_count, int iterations) {
+    TTStressWorker workers[MAX_THREADS];
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > MAX_THREADS) thread_count = MAX_THREADS;
+
+    tt_resize(1);
+
+    int started = 0;
+    for (int i = 0; i < thread_count; i++) {
+        workers[i] = (TTStressWorker){ .id = i, .iterations = iterations };
+        if (pthread_create(&workers[i].handle, NULL, tt_stress_worker, &workers[i]) != 0) break;
+        started++;
+    }
+
+    uint64_t hits = 0, torn = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].handle, NULL);
+        hits += workers[i].hits;
+        torn += workers[i].torn;
+    }
+
+    printf("tt stress: %d threads, %llu hits, %llu torn entries\n",
+           started, (unsigned long long)hits, (unsigned long long)torn);
+
+    tt_resize(TT_DEFAULT_MB);
+    return torn;
+}
+
+// Positions with castling, en passant, promotions and pins, shared by the move generation checks
+static const char* const test_fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+};
+#define TEST_FEN_COUNT (int)(sizeof(test_fens) / sizeof(test_fens[0]))
+
+static bool move_list_contains(const MoveList* list, int move) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->moves[i] == move) return true;
+    }
+    return false;
+}
+
+// Checks one position: the noisy and quiet generators split the legal moves exactly, the move
+// pickers hand out legal moves only once, and the pseudo-legality test accepts a foreign move
+// (taken from the parent position) exactly when it is legal here. Returns the number of errors.
+static int check_move_picker_position(const Position* pos, const MoveList* foreign, const MagicData* magic, const ZobristKeys* keys) {
+    int errors = 0;
+    int side = pos->side_to_move;
+
+    MoveList all, noisy, quiet;
+    LegalityInfo info;
+    compute_legality_info(pos, side, &info, magic);
+    generate_legal_moves(pos, &all, side, magic, keys);
+    generate_moves(pos, &noisy, side, GEN_NOISY, &info, magic, keys);
+    generate_moves(pos, &quiet, side, GEN_QUIET, &info, magic, keys);
+
+    if (noisy.count + quiet.count != all.count) errors++;
+    for (int i = 0; i < noisy.count; i++) {
+        if (!move_is_noisy(noisy.moves[i]) || !move_list_contains(&all, noisy.moves[i])) errors++;
+    }
+    for (int i = 0; i < quiet.count; i++) {
+        if (move_is_noisy(quiet.moves[i]) || !move_list_contains(&all, quiet.moves[i])) errors++;
+    }
+
+    // Feed the picker foreign moves as TT, killer and counter moves so that the validation is exercised
+    SearchThread* td = calloc(1, sizeof(SearchThread));
+    if (!td) return errors + 1;
+    int pick = foreign->count ? foreign->moves[0] : 0;
+    td->killer_moves[1][0] = foreign->count > 1 ? foreign->moves[1] : 0;
+    td->killer_moves[1][1] = all.count ? all.moves[all.count - 1] : 0;
+    int counter = foreign->count > 2 ? foreign->moves[2] : 0;
+
+    MovePicker picker;
+    init_move_picker(&picker, td, pos, 1, pick, counter, magic, keys);
+    MoveList picked = { .count = 0 };
+    int move;
+    while ((move = next_move(&picker)) != 0) {
+        if (!move_list_contains(&all, move) || move_list_contains(&picked, move)) errors++;
+        else picked.moves[picked.count++] = move;
+    }
+    if (picked.count != all.count) errors++;
+    free(td);
+
+    // The quiescence picker hands out a subset of the noisy moves, again without duplicates
+    init_qsearch_picker(&picker, pos, magic, keys);
+    picked.count = 0;
+    while ((move = next_move(&picker)) != 0) {
+        if (!move_list_contains(&noisy, move) || move_list_contains(&picked, move)) errors++;
+        else picked.moves[picked.count++] = move;
+    }
+
+    for (int i = 0; i < foreign->count; i++) {
+        int m = foreign->moves[i];
+        bool valid = is_pseudo_legal_move(pos, m, magic) && is_legal_move_fast(pos, m, &info, magic, keys);
+        if (valid != move_list_contains(&all, m)) errors++;
+    }
+    return errors;
+}
+
+// Runs the position check on every test position and on all of their children
+int move_picker_test(const MagicData* magic, const ZobristKeys* keys) {
+    int errors = 0;
+    int positions = 0;
+
+    for (int f = 0; f < TEST_FEN_COUNT; f++) {
+        Position pos;
+        init_position(&pos, test_fens[f]);
+        pos.zobrist_hash = compute_zobrist_hash(&pos, keys);
+        pos.pawn_hash = compute_pawn_hash(&pos, keys);
+
+        MoveList root;
+        generate_legal_moves(&pos, &root, pos.side_to_move, magic, keys);
+        errors += check_move_picker_position(&pos, &root, magic, keys);
+        positions++;
+
+        for (int i = 0; i < root.count; i++) {
+            MoveState state;
+            if (!make_move(&pos, &state, root.moves[i], keys)) continue;
+            errors += check_move_picker_position(&pos, &root, magic, keys);
+            positions++;
+            unmake_move(&pos, &state, keys);
+        }
+    }
+
+    printf("move picker: %d positions, %d errors\n", positions, errors);
+    return errors;
+}
+
+// Walks the tree below pos and counts the nodes where the incrementally updated material, PST,
+// phase or hash keys differ from a full recompute, after make_move() as well as after unmake_move()
+static int check_psq_tree(Position* pos, int depth, const MagicData* magic, const ZobristKeys* keys) {
+    int mg, eg, phase;
+    compute_psq_state(pos, &mg, &eg, &phase);
+    int errors = (mg != pos->psq_mg || eg != pos->psq_eg || phase != pos->phase ||
+                  pos->pawn_hash != compute_pawn_hash(pos, keys) ||
+                  pos->zobrist_hash != compute_zobrist_hash(pos, keys));
+    if (depth == 0) return errors;
+
+    MoveList list;
+    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+    for (int i = 0; i < list.count; i++) {
+        MoveState state;
+        if (!make_move(pos, &state, list.moves[i], keys)) continue;
+        errors += check_psq_tree(pos, depth - 1, magic, keys);
+        unmake_move(pos, &state, keys);
+    }
+
+    compute_psq_state(pos, &mg, &eg, &phase);
+    return errors + (mg != pos->psq_mg || eg != pos->psq_eg || phase != pos->phase ||
+                     pos->zobrist_hash != compute_zobrist_hash(pos, keys));
+}
+
+// The cached pawn structure terms must match the per-pawn evaluation they replace
+static int check_pawn_entry(const Position* pos, const EvalParams* params, PawnTable* table) {
+    FeatureCounts counts;
+    int mg = 0, eg = 0;
+    for (int side = WHITE; side <= BLACK; side++) {
+        evaluate_passed_pawns(pos, &counts, params, NULL, side, &mg, &eg, NULL, NULL);
+        evaluate_knight_outposts(pos, &counts, params, NULL, side, &mg, &eg, NULL, NULL);
+    }
+
+    const PawnEntry* entry = probe_pawn_table(table, pos, params);
+    int sign = (pos->side_to_move == WHITE) ? +1 : -1;
+    int cached_mg = sign * entry->mg, cached_eg = sign * entry->eg;
+    for (int side = WHITE; side <= BLACK; side++) {
+        int outposts = count_bits(pos->pieces[side == WHITE ? WN : BN] & entry->attacks[side] & ~entry->attack_span[side ^ 1]);
+        int eval_sign = (side == pos->side_to_move) ? +1 : -1;
+        cached_mg += eval_sign * outposts * params->knight_outpost_bonus_mg;
+        cached_eg += eval_sign * outposts * params->knight_outpost_bonus_eg;
+    }
+    return mg != cached_mg || eg != cached_eg;
+}
+
+// Pawn structure cache check over the children of every test position
+static int pawn_table_test(const MagicData* magic, const ZobristKeys* keys) {
+    PawnTable* table = calloc(1, sizeof(PawnTable));
+    if (!table) return 1;
+    EvalParams params;
+    set_default_evalparams(&params);
+
+    int errors = 0;
+    for (int f = 0; f < TEST_FEN_COUNT; f++) {
+        Position pos;
+        init_position(&pos, test_fens[f]);
+        pos.zobrist_hash = compute_zobrist_hash(&pos, keys);
+        pos.pawn_hash = compute_pawn_hash(&pos, keys);
+        errors += check_pawn_entry(&pos, &params, table);
+
+        MoveList list;
+        generate_legal_moves(&pos, &list, pos.side_to_move, magic, keys);
+        for (int i = 0; i < list.count; i++) {
+            MoveState state;
+            if (!make_move(&pos, &state, list.moves[i], keys)) continue;
+            errors += check_pawn_entry(&pos, &params, table);
+            unmake_move(&pos, &state, keys);
+        }
+    }
+
+    free(table);
+    return errors;
+}
+
+int incremental_eval_test(const MagicData* magic, const ZobristKeys* keys) {
+    int errors = pawn_table_test(magic, keys);
+    for (int f = 0; f < TEST_FEN_COUNT; f++) {
+        Position pos;
+        init_position(&pos, test_fens[f]);
+        pos.zobrist_hash = compute_zobrist_hash(&pos, keys);
+        pos.pawn_hash = compute_pawn_hash(&pos, keys);
+        errors += check_psq_tree(&pos, 3, magic, keys);
+    }
+
+    printf("incremental eval: %d errors\n", errors);
+    return errors;
+}
+
+// The geometry tables against a square by square reference, using the slider attacks for lines
+int geometry_test(const MagicData* magic) {
+    int errors = 0;
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            int df = abs(FILE(a) - FILE(b)), dr = RANK(b) - RANK(a);
+            Bitboard b_bb = 1ULL << b;
+
+            errors += ((knight_attacks(a) & b_bb) != 0) != ((df == 1 && abs(dr) == 2) || (df == 2 && abs(dr) == 1));
+            errors += ((king_attacks(a) & b_bb) != 0) != (a != b && df <= 1 && abs(dr) <= 1);
+            errors += ((pawn_attacks(a, WHITE) & b_bb) != 0) != (df == 1 && dr == 1);
+            errors += ((pawn_attacks(a, BLACK) & b_bb) != 0) != (df == 1 && dr == -1);
+            errors += manhattan(a, b) != df + abs(dr);
+
+            Bitboard between = 0, line = 0;
+            if (a != b && (rook_attacks(a, 0, magic) & b_bb)) {
+                between = rook_attacks(a, b_bb, magic) & rook_attacks(b, 1ULL << a, magic);
+                line = (rook_attacks(a, 0, magic) & rook_attacks(b, 0, magic)) | (1ULL << a) | b_bb;
+            } else if (a != b && (bishop_attacks(a, 0, magic) & b_bb)) {
+                between = bishop_attacks(a, b_bb, magic) & bishop_attacks(b, 1ULL << a, magic);
+                line = (bishop_attacks(a, 0, magic) & bishop_attacks(b, 0, magic)) | (1ULL << a) | b_bb;
+            }
+            errors += squares_between_exclusive(a, b) != between;
+            errors += line_table[a][b] != line;
+        }
+    }
+
+    printf("geometry: %d errors\n", errors);
+    return errors;
+}
+
+// The magic and PEXT slider backends against each other and the ray walk, for every blocker subset
+// with unrelated pieces scattered outside the mask. The compiled in tables must also match a fresh build.
+int slider_backend_test(const MagicData* magic) {
+    int errors = 0;
+
+    MagicData* fresh = calloc(1, sizeof(MagicData));
+    if (!fresh) return 1;
+    build_magic_tables(fresh);
+    errors += memcmp(fresh, &magic_data, sizeof(MagicData)) != 0;
+    free(fresh);
+    uint64_t noise = 0x9E3779B97F4A7C15ULL;
+
+    for (int sq = 0; sq < 64; sq++) {
+        uint64_t rook_limit = 1ULL << count_bits(magic->rook_masks[sq]);
+        for (uint64_t index = 0; index < rook_limit; index++) {
+            Bitboard blockers = set_blockers_from_index(index, magic->rook_masks[sq]);
+            noise = stress_mix(noise);
+            Bitboard occ = blockers | (noise & ~magic->rook_masks[sq]);
+            Bitboard expected = compute_rook_attacks(sq, blockers);
+            errors += rook_attacks_magic(sq, occ, magic) != expected;
+            errors += rook_attacks_pext(sq, occ, magic) != expected;
+        }
+
+        uint64_t bishop_limit = 1ULL << count_bits(magic->bishop_masks[sq]);
+        for (uint64_t index = 0; index < bishop_limit; index++) {
+            Bitboard blockers = set_blockers_from_index(index, magic->bishop_masks[sq]);
+            noise = stress_mix(noise);
+            Bitboard occ = blockers | (noise & ~magic->bishop_masks[sq]);
+            Bitboard expected = compute_bishop_attacks(sq, blockers);
+            errors += bishop_attacks_magic(sq, occ, magic) != expected;
+            errors += bishop_attacks_pext(sq, occ, magic) != expected;
+        }
+    }
+
+#ifdef USE_PEXT
+    printf("slider backends (PEXT in use): %d errors\n", errors);
+#else
+    printf("slider backends (magics in use): %d errors\n", errors);
+#endif
+    return errors;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Everything the Zobrist hash covers, to tell real collisions from transpositions
+typedef struct {
+    uint64_t key;
+    Bitboard pieces[12];
+    int side_to_move;
+    int castling_rights;
+    int en_passant;
+} HashedPosition;
+
+static int compare_hashed_positions(const void* a, const void* b) {
+    return compare_u64(&((const HashedPosition*)a)->key, &((const HashedPosition*)b)->key);
+}
+
+static void collect_hashed_positions(Position* pos, int depth, HashedPosition* out, int* count, int capacity,
+                                     const MagicData* magic, const ZobristKeys* keys) {
+    if (*count < capacity) {
+        HashedPosition* h = &out[(*count)++];
+        memset(h, 0, sizeof(HashedPosition));
+        h->key = pos->zobrist_hash;
+        memcpy(h->pieces, pos->pieces, sizeof(h->pieces));
+        h->side_to_move = pos->side_to_move;
+        h->castling_rights = pos->castling_rights;
+        h->en_passant = (pos->en_passant == -1) ? -1 : pos->en_passant % 8;
+    }
+    if (depth == 0) return;
+
+    MoveList list;
+    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+    for (int i = 0; i < list.count; i++) {
+        MoveState state;
+        if (!make_move(pos, &state, list.moves[i], keys)) continue;
+        collect_hashed_positions(pos, depth - 1, out, count, capacity, magic, keys);
+        unmake_move(pos, &state, keys);
+    }
+}
+
+// Key quality: all keys distinct and non-zero, none the XOR of two others (so no two single changes
+// cancel a third), every bit set in roughly half of the keys, and no collisions between the
+// different positions of a small tree below each test position
+int zobrist_key_test(const MagicData* magic, const ZobristKeys* keys) {
+    enum { KEY_COUNT = sizeof(ZobristKeys) / sizeof(uint64_t) };
+    uint64_t sorted[KEY_COUNT];
+    memcpy(sorted, keys, sizeof(sorted));
+    qsort(sorted, KEY_COUNT, sizeof(uint64_t), compare_u64);
+
+    int errors = (sorted[0] == 0);
+    for (int i = 1; i < KEY_COUNT; i++) errors += (sorted[i] == sorted[i - 1]);
+
+    for (int i = 0; i < KEY_COUNT; i++) {
+        for (int j = i + 1; j < KEY_COUNT; j++) {
+            uint64_t x = sorted[i] ^ sorted[j];
+            errors += bsearch(&x, sorted, KEY_COUNT, sizeof(uint64_t), compare_u64) != NULL;
+        }
+    }
+
+    for (int bit = 0; bit < 64; bit++) {
+        int set = 0;
+        for (int i = 0; i < KEY_COUNT; i++) set += (sorted[i] >> bit) & 1;
+        errors += (set < KEY_COUNT * 2 / 5 || set > KEY_COUNT * 3 / 5);
+    }
+
+    const int capacity = 1 << 17;
+    HashedPosition* positions = malloc(sizeof(HashedPosition) * capacity);
+    if (!positions) return errors + 1;
+    int count = 0;
+    for (int f = 0; f < TEST_FEN_COUNT; f++) {
+        Position pos;
+        init_position(&pos, test_fens[f]);
+        pos.zobrist_hash = compute_zobrist_hash(&pos, keys);
+        pos.pawn_hash = compute_pawn_hash(&pos, keys);
+        collect_hashed_positions(&pos, 2, positions, &count, capacity, magic, keys);
+    }
+    qsort(positions, count, sizeof(HashedPosition), compare_hashed_positions);
+    for (int i = 1; i < count; i++) {
+        errors += (positions[i].key == positions[i - 1].key &&
+                   memcmp(&positions[i], &positions[i - 1], sizeof(HashedPosition)) != 0);
+    }
+    free(positions);
+
+    printf("zobrist keys: %d keys, %d positions, %d errors\n", (int)KEY_COUNT, count, errors);
+    return errors;
+}
+
+// Plain make/unmake recursion down to the leaves, the reference for the bulk counting perft
+static uint64_t reference_perft(Position* pos, int depth, const MagicData* magic, const ZobristKeys* keys) {
+    if (depth == 0) return 1;
+    MoveList list;
+    generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
+    uint64_t nodes = 0;
+    for (int i = 0; i < list.count; i++) {
+        MoveState state;
+        if (!make_move(pos, &state, list.moves[i], keys)) continue;
+        nodes += reference_perft(pos, depth - 1, magic, keys);
+        unmake_move(pos, &state, keys);
+    }
+    return nodes;
+}
+
+static const struct {
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+} known_perfts[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609ULL},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194ULL},
+};
+
+#define KNOWN_PERFT_COUNT (int)(sizeof(known_perfts) / sizeof(known_perfts[0]))
+
+// Bulk counting and the perft hash table must not change any count
+int perft_test(const MagicData* magic, const ZobristKeys* keys) {
+    PerftTable table;
+    if (!perft_table_init(&table, 1)) return 1;
+
+    int errors = 0;
+    for (int f = 0; f < TEST_FEN_COUNT; f++) {
+        Position pos;
+        init_position(&pos, test_fens[f]);
+        pos.zobrist_hash = compute_zobrist_hash(&pos, keys);
+        pos.pawn_hash = compute_pawn_hash(&pos, keys);
+
+        uint64_t expected = reference_perft(&pos, 3, magic, keys);
+        errors += perft(&pos, 3, NULL, magic, keys) != expected;
+        errors += perft(&pos, 3, &table, magic, keys) != expected;
+        errors += perft(&pos, 3, &table, magic, keys) != expected; // Now served from the table
+    }
+
+    // Published counts, so a bug shared by both versions shows up too. The castling positions make
+    // the hash go through every change of castling rights, which the table depends on.
+    for (int i = 0; i < KNOWN_PERFT_COUNT; i++) {
+        Position pos;
+        init_position(&pos, known_perfts[i].fen);
+        pos.zobrist_hash = compute_zobrist_hash(&pos, keys);
+        pos.pawn_hash = compute_pawn_hash(&pos, keys);
+        errors += perft(&pos, known_perfts[i].depth, &table, magic, keys) != known_perfts[i].nodes;
+    }
+
+    perft_table_free(&table);
+    printf("perft: %d errors\n", errors);
+    return errors;
+}
+
+// Black is a queen up and shuffles a queen or a bishop, neither of which resets the halfmove clock
+static const struct {
+    const char* fen;
+    const char* shuffle[8];
+} shuffle_games[] = {
+    {"3q3k/8/8/8/8/8/8/KN6 w - - 0 1", {"b1c3", "d8d7", "c3b1", "d7d8", "b1c3", "d8d7", "c3b1", "d7d8"}},
+    {"3b3k/8/4q3/8/8/8/8/KN6 w - - 0 1", {"b1c3", "d8e7", "c3b1", "e7d8", "b1c3", "d8e7", "c3b1", "e7d8"}},
+};
+
+#define SHUFFLE_GAME_COUNT (int)(sizeof(shuffle_games) / sizeof(shuffle_games[0]))
+
+// With the game history, Nc3 repeats a position for the third time and the search has to see
+// the draw; without it, White is simply lost.
+int repetition_test(const MagicData* magic, const ZobristKeys* keys) {
+    EvalParams params;
+    set_default_evalparams(&params);
+
+    int errors = 0;
+    for (int g = 0; g < SHUFFLE_GAME_COUNT; g++) {
+        Position pos;
+        init_position(&pos, shuffle_games[g].fen);
+        pos.zobrist_hash = compute_zobrist_hash(&pos, keys);
+        pos.pawn_hash = compute_pawn_hash(&pos, keys);
+
+        GameHistory history = {.count = 0};
+        MoveState state;
+        for (int i = 0; i < 8; i++) {
+            history.keys[history.count++] = pos.zobrist_hash;
+            make_move(&pos, &state, parse_move(&pos, shuffle_games[g].shuffle[i], magic, keys), keys);
+        }
+
+        tt_init();
+        find_best_move(&pos, 4, NULL, &history, &params, magic, keys, NULL, NULL);
+        int draw_score = get_search_score();
+        errors += draw_score < -100;
+
+        tt_init();
+        find_best_move(&pos, 4, NULL, NULL, &params, magic, keys, NULL, NULL);
+        int lost_score = get_search_score();
+        errors += lost_score > -300;
+
+        printf("repetition: score %d with history, %d without\n", draw_score, lost_score);
+    }
+    return errors;
+}
+
+// After the first four moves of a shuffle game White is lost but can play Nc3 into the position
+// three plies back; the search must take that as a draw even though Black's last move was no pawn move
+static int check_upcoming_cycle(int game, const MagicData* magic, const ZobristKeys* keys) {
+    EvalParams params;
+    set_default_evalparams(&params);
+    SearchThread* td = calloc(1, sizeof(SearchThread));
+    if (!td) return 1;
+    td->params = &params;
+    td->magic = magic;
+    td->keys = keys;
+
+    init_position(&td->pos, shuffle_games[game].fen);
+    td->pos.zobrist_hash = compute_zobrist_hash(&td->pos, keys);
+    td->pos.pawn_hash = compute_pawn_hash(&td->pos, keys);
+    MoveState state;
+    for (int i = 0; i < 4; i++) {
+        make_move(&td->pos, &state, parse_move(&td->pos, shuffle_games[game].shuffle[i], magic, keys), keys);
+        if (i < 3) td->repetition_table[td->repetition_index++] = td->pos.zobrist_hash;
+    }
+
+    // Null window just below the draw, at a ply that puts the earlier positions inside the tree
+    tt_init();
+    atomic_store(&search_stopped, 0);
+    int score = search(td, &td->pos, 0, 4, DRAW_SCORE - 1, DRAW_SCORE, 0, &params, magic, keys);
+    free(td);
+    return score < DRAW_SCORE;
+}
+
+// Every knight, bishop, rook, queen and king move of the empty board must be found again under the
+// key difference it makes, with its squares, and nothing else may be in the table
+int cuckoo_test(const MagicData* magic, const ZobristKeys* keys) {
+    int errors = 0;
+    int stored = init_cuckoo(keys);
+    errors += stored != 3668;
+
+    int found = 0;
+    for (int piece = 0; piece < 12; piece++) {
+        if (piece % 6 == P) continue;
+        for (int s1 = 0; s1 < 64; s1++) {
+            for (int s2 = 0; s2 < 64; s2++) {
+                uint64_t key = keys->zobrist_pieces[piece][s1] ^ keys->zobrist_pieces[piece][s2] ^ keys->zobrist_side;
+                int slot = (cuckoo_keys[CUCKOO_H1(key)] == key) ? CUCKOO_H1(key) :
+                           (cuckoo_keys[CUCKOO_H2(key)] == key) ? CUCKOO_H2(key) : -1;
+                if (slot < 0) continue;
+
+                int a = s1 < s2 ? s1 : s2, b = s1 < s2 ? s2 : s1;
+                errors += cuckoo_moves[slot] != ((a << 6) | b);
+                if (s1 < s2) found++;
+            }
+        }
+    }
+    errors += found != stored;
+
+    for (int g = 0; g < SHUFFLE_GAME_COUNT; g++) {
+        errors += check_upcoming_cycle(g, magic, keys);
+    }
+
+    printf("cuckoo: %d moves, %d errors\n", stored, errors);
+    return errors;
+}
+
+// Runs every self-check and returns the number of failed ones
+int run_self_tests(const MagicData* magic, const ZobristKeys* keys) {
+    int failures = 0;
+
+    if (geometry_test(magic) != 0) {
+        printf("FAILED: geometry tables\n");
+        failures++;
+    }
+
+    if (slider_backend_test(magic) != 0) {
+        printf("FAILED: slider attack backends\n");
+        failures++;
+    }
+
+    if (zobrist_key_test(magic, keys) != 0) {
+        printf("FAILED: zobrist key quality\n");
+        failures++;
+    }
+
+    if (perft_test(magic, keys) != 0) {
+        printf("FAILED: perft counts\n");
+        failures++;
+    }
+
+    if (move_picker_test(magic, keys) != 0) {
+        printf("FAILED: staged move generation\n");
+        failures++;
+    }
+
+    if (cuckoo_test(magic, keys) != 0) {
+        printf("FAILED: cuckoo tables\n");
+        failures++;
+    }
+
+    if (repetition_test(magic, keys) != 0) {
+        printf("FAILED: repetition detection\n");
+        failures++;
+    }
+
+    if (incremental_eval_test(magic, keys) != 0) {
+        printf("FAILED: incremental evaluation accumulators\n");
+        failures++;
+    }
+
+    if (tt_stress_test(8, 2000000) != 0) {
+        printf("FAILED: torn transposition table entries\n");
+        failures++;
+    }
+
+    printf("%s\n", failures ? "Self tests failed" : "All self tests passed");
+    return failures;
+}
@@ -0,0 +1,57 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime and nanosleep under -std=c11
+
+#include "timeman.h"
+#include <time.h>
+
+#define DEFAULT_MOVES_TO_GO 30 // Assumed number of moves left when the GUI gives no movestogo
+
+int64_t time_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+void init_time_manager(TimeManager* tm, const SearchLimits* limits, int side, int move_overhead) {
+    tm->start = time_now_ms();
+    tm->active = 0;
+    tm->soft_limit = tm->hard_limit = 0;
+
+    if (limits->infinite) return;
+
+    // A fixed time per move is used up to the overhead, with no reason to stop early
+    if (limits->movetime > 0) {
+        int64_t limit = limits->movetime - move_overhead;
+        if (limit < 1) limit = 1;
+        tm->soft_limit = tm->hard_limit = limit;
+        tm->active = 1;
+        return;
+    }
+
+    if (limits->time[side] <= 0) return;
+
+    int64_t time_left = limits->time[side] - move_overhead;
+    if (time_left < 1) time_left = 1;
+    int moves_to_go = (limits->movestogo > 0) ? limits->movestogo : DEFAULT_MOVES_TO_GO;
+    int64_t inc = limits->inc[side];
+
+    // Aim for an even share of the remaining time plus most of the increment, and allow an
+    // iteration in progress to run up to four times as long before it is cut off
+    int64_t soft = time_left / moves_to_go + inc * 3 / 4;
+    int64_t hard = soft * 4;
+
+    // Never plan to spend more than half the clock, or most of it right before the time control
+    int64_t cap = (moves_to_go == 1) ? time_left * 9 / 10 : time_left / 2;
+    if (soft > cap) soft = cap;
+    if (hard > cap) hard = cap;
+    if (soft < 1) soft = 1;
+    if (hard < soft) hard = soft;
+
+    tm->soft_limit = soft;
+    tm->hard_limit = hard;
+    tm->active = 1;
+}
@@ -1,51 +1,173 @@
+#include "evalsearch.h"
 #include "tt.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-TTEntry transposition_table[TT_SIZE];
+// Scores within this distance of MATE_SCORE are mate scores and keep their distance to mate
+#define TT_MATE_RANGE 1000
+#define TT_SCORE_MATE 32000
 
-void tt_init() {
-    for (int i = 0; i < TT_SIZE; i++) {
-        transposition_table[i].key = 0ULL;
-        transposition_table[i].depth = -1;
-        transposition_table[i].score = 0;
-        transposition_table[i].best_move = 0;
-        transposition_table[i].flag = TT_NONE;
+TranspositionTable transposition_table;
+
+// MATE_SCORE does not fit into 16 bits, so mate scores are shifted next to TT_SCORE_MATE
+static inline int16_t score_to_tt(int score) {
+    if (score > MATE_SCORE - TT_MATE_RANGE) return (int16_t)(TT_SCORE_MATE - (MATE_SCORE - score));
+    if (score < -MATE_SCORE + TT_MATE_RANGE) return (int16_t)(-TT_SCORE_MATE + (MATE_SCORE + score));
+    if (score > TT_SCORE_MATE - TT_MATE_RANGE) return TT_SCORE_MATE - TT_MATE_RANGE;
+    if (score < -TT_SCORE_MATE + TT_MATE_RANGE) return -TT_SCORE_MATE + TT_MATE_RANGE;
+    return (int16_t)score;
+}
+
+static inline int score_from_tt(int16_t score) {
+    if (score > TT_SCORE_MATE - TT_MATE_RANGE) return MATE_SCORE - (TT_SCORE_MATE - score);
+    if (score < -TT_SCORE_MATE + TT_MATE_RANGE) return -MATE_SCORE + (TT_SCORE_MATE + score);
+    return score;
+}
+
+int tt_resize(size_t size_mb) {
+    if (size_mb < 1) size_mb = 1;
+    if (size_mb > TT_MAX_MB) size_mb = TT_MAX_MB;
+
+    uint64_t bucket_count = ((uint64_t)size_mb << 20) / sizeof(TTBucket);
+    TTBucket* buckets = aligned_alloc(sizeof(TTBucket), bucket_count * sizeof(TTBucket));
+    if (!buckets) {
+        fprintf(stderr, "Failed to allocate %zu MB transposition table\n", size_mb);
+        return 0;
     }
+
+    free(transposition_table.buckets);
+    transposition_table.buckets = buckets;
+    transposition_table.bucket_count = bucket_count;
+    tt_init();
+    return 1;
+}
+
+size_t tt_size_mb(void) {
+    return (size_t)((transposition_table.bucket_count * sizeof(TTBucket)) >> 20);
+}
+
+void tt_init() {
+    if (!transposition_table.buckets) return;
+    memset(transposition_table.buckets, 0, transposition_table.bucket_count * sizeof(TTBucket));
+    transposition_table.generation = 0;
+}
+
+// Called once per search so that entries from earlier searches become preferred victims
+void tt_new_search() {
+    transposition_table.generation = (transposition_table.generation + 1) & (TT_GENERATIONS - 1);
+}
+
+// Both words are accessed with relaxed atomics: plain loads and stores on x86-64, but the compiler
+// may not split or merge them, which the XOR verification relies on
+static inline void tt_read(const TTEntry* entry, uint64_t* key, uint64_t* data) {
+    *data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    *key = atomic_load_explicit(&entry->key, memory_order_relaxed) ^ *data;
+}
+
+static inline void tt_write(TTEntry* entry, uint64_t key, uint64_t data) {
+    atomic_store_explicit(&entry->key, key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&entry->data, data, memory_order_relaxed);
 }
 
-void tt_store(uint64_t key, int depth, int score, int best_move, TTFlag flag) {
-    int index = tt_index(key);
-    TTEntry* entry = &transposition_table[index];
+void tt_store(uint64_t key, int depth, int score, int static_eval, int best_move, TTFlag flag) {
+    TTBucket* bucket = tt_bucket(key);
+    TTEntry* replace = NULL;
+    uint64_t replace_key = 0, replace_data = 0;
+    int replace_worth = 0;
 
-    // Always store if the slot is empty or if this entry is deeper
-    if (entry->key == 0 || depth >= entry->depth) {
-        entry->key = key;
-        entry->depth = depth;
-        entry->score = score;
-        entry->best_move = best_move;
-        entry->flag = flag;
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+        TTEntry* entry = &bucket->entries[i];
+        uint64_t entry_key, entry_data;
+        tt_read(entry, &entry_key, &entry_data);
+
+        if (tt_data_flag(entry_data) == TT_NONE || entry_key == key) {
+            replace = entry;
+            replace_key = entry_key;
+            replace_data = entry_data;
+            break;
+        }
+
+        // Shallow entries and entries left over from earlier searches are replaced first
+        int worth = tt_data_depth(entry_data) - 8 * tt_data_age(entry_data);
+        if (!replace || worth < replace_worth) {
+            replace = entry;
+            replace_key = entry_key;
+            replace_data = entry_data;
+            replace_worth = worth;
+        }
+    }
+
+    int same_position = tt_data_flag(replace_data) != TT_NONE && replace_key == key;
+
+    // Keep a deeper result for the same position unless it is stale or the new one is exact
+    if (same_position && flag != TT_EXACT &&
+        depth < tt_data_depth(replace_data) && tt_data_age(replace_data) == 0) {
+        return;
     }
+
+    if (depth < 0) depth = 0;
+    if (depth > 255) depth = 255;
+    if (!best_move && same_position) best_move = tt_data_move(replace_data);
+    if (static_eval == TT_EVAL_NONE && same_position) static_eval = tt_data_eval(replace_data);
+    if (static_eval != TT_EVAL_NONE) {
+        if (static_eval > INT16_MAX) static_eval = INT16_MAX;
+        if (static_eval < -INT16_MAX) static_eval = -INT16_MAX;
+    }
+
+    uint64_t data = tt_pack(best_move, score_to_tt(score), depth, (transposition_table.generation << 2) | flag, (int16_t)static_eval);
+    tt_write(replace, key, data);
 }
 
-int tt_probe(uint64_t key, int depth, int alpha, int beta, int* out_score, int* out_move) {
-    int index = tt_index(key);
-    TTEntry* entry = &transposition_table[index];
+TTProbe tt_probe(uint64_t key, int depth, int alpha, int beta, int* out_score, int* out_move, int* out_eval) {
+    TTBucket* bucket = tt_bucket(key);
 
-    if (entry->key == key && entry->depth >= depth) {
-        *out_move = entry->best_move;
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+        uint64_t entry_key, data;
+        tt_read(&bucket->entries[i], &entry_key, &data);
+        TTFlag flag = tt_data_flag(data);
 
-        if (entry->flag == TT_EXACT) {
-            *out_score = entry->score;
-            return 1;
+        if (flag == TT_NONE || entry_key != key) continue;
+
+        // The stored move and static eval are worth having even when the entry is too shallow for a cutoff
+        *out_move = tt_data_move(data);
+        *out_eval = tt_data_eval(data);
+        if (tt_data_depth(data) < depth) return TT_PROBE_HIT;
+
+        int score = score_from_tt(tt_data_score(data));
+
+        if (flag == TT_EXACT) {
+            *out_score = score;
+            return TT_PROBE_CUTOFF;
         }
-        if (entry->flag == TT_ALPHA && entry->score <= alpha) {
+        if (flag == TT_ALPHA && score <= alpha) {
             *out_score = alpha;
-            return 1;
+            return TT_PROBE_CUTOFF;
         }
-        if (entry->flag == TT_BETA && entry->score >= beta) {
+        if (flag == TT_BETA && score >= beta) {
             *out_score = beta;
-            return 1;
+            return TT_PROBE_CUTOFF;
         }
+        return TT_PROBE_HIT;
     }
 
-    return 0; // Not usable
-}
\ No newline at end of file
+    return TT_PROBE_MISS;
+}
+
+// Permille of the table filled by the current search, estimated from the first 1000 entries
+// as the UCI hashfull field expects
+int tt_hashfull(void) {
+    uint64_t buckets = 1000 / TT_BUCKET_SIZE;
+    if (buckets > transposition_table.bucket_count) buckets = transposition_table.bucket_count;
+    if (buckets == 0) return 0;
+
+    int used = 0;
+    for (uint64_t b = 0; b < buckets; b++) {
+        for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+            uint64_t data = atomic_load_explicit(&transposition_table.buckets[b].entries[i].data, memory_order_relaxed);
+            if (tt_data_flag(data) != TT_NONE && tt_data_age(data) == 0) used++;
+        }
+    }
+    return (int)(used * 1000 / (buckets * TT_BUCKET_SIZE));
+}
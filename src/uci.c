@@ -1,18 +1,48 @@
 // --- Modified uci.c with InstantMate support ---
+#include "bench.h"
 #include "evalparams.h"
 #include "evalsearch.h"
+#include "perft.h"
 #include "test.h"
+#include "timeman.h"
+#include "tt.h"
 #include "uci.h"
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #define STARTPOS_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 
-static int forced_mate_line[32];
+// Mating line of the last search for InstantMate: our moves at even indices, the expected replies
+// at odd ones. forced_mate_keys[i] is the position after line[i], used to confirm that the
+// opponent played the expected reply. forced_mate_index is the next reply to expect.
+static int forced_mate_line[MAX_PLY];
+static uint64_t forced_mate_keys[MAX_PLY];
 static int forced_mate_index = 0;
 static int forced_mate_length = 0;
 static int instant_mate_mode = 0;  // InstantMate option flag
+static int ponder_mode = 0;        // Ponder option flag: bestmove comes with the expected reply
+static int move_overhead = DEFAULT_MOVE_OVERHEAD;
+static GameHistory game_history; // Positions before the current one, fed by the position command
+
+// Everything the search thread needs for one go command. The UCI thread only touches it while
+// no search is running, so it needs no locking.
+typedef struct {
+    Position* pos;
+    MoveList* list;
+    const MagicData* magic;
+    const ZobristKeys* keys;
+    int depth;
+    const GameHistory* history;
+    SearchLimits limits;
+    TimeManager time;
+} SearchJob;
+
+static SearchJob search_job;
+static pthread_t search_thread;
+static int search_running = 0;
 
 void move_to_uci(int move, char out[6]) {
     int from = MOVE_FROM(move);
@@ -36,7 +66,7 @@ void move_to_uci(int move, char out[6]) {
     }
 }
 
-int parse_move(const Position* pos, const char* uci_str, const MagicData* magic, ZobristKeys* keys) {
+int parse_move(const Position* pos, const char* uci_str, const MagicData* magic, const ZobristKeys* keys) {
     MoveList list;
     generate_legal_moves(pos, &list, pos->side_to_move, magic, keys);
 
@@ -50,18 +80,158 @@ int parse_move(const Position* pos, const char* uci_str, const MagicData* magic,
     return 0;
 }
 
-void uci_loop(Position* pos, MoveList* list, MoveState* state, int depth, const MagicData* magic, ZobristKeys* keys) {
+// Reads the go command parameters, leaving the ones that are not given at 0
+static void parse_go(const char* line, SearchLimits* limits) {
+    memset(limits, 0, sizeof(SearchLimits));
+
+    const char* p;
+    if ((p = strstr(line, "wtime"))) limits->time[WHITE] = atoi(p + 6);
+    if ((p = strstr(line, "btime"))) limits->time[BLACK] = atoi(p + 6);
+    if ((p = strstr(line, "winc"))) limits->inc[WHITE] = atoi(p + 5);
+    if ((p = strstr(line, "binc"))) limits->inc[BLACK] = atoi(p + 5);
+    if ((p = strstr(line, "movestogo"))) limits->movestogo = atoi(p + 10);
+    if ((p = strstr(line, "movetime"))) limits->movetime = atoi(p + 9);
+    if ((p = strstr(line, "depth"))) limits->depth = atoi(p + 6);
+    if (strstr(line, "infinite")) limits->infinite = 1;
+    if (strstr(line, "ponder")) limits->ponder = 1;
+}
+
+// Expected reply to our move: the second PV move, or the hash move of the position after our move
+static int find_ponder_move(const Position* pos, int move, const int* pv_line, int pv_len,
+                            const MagicData* magic, const ZobristKeys* keys) {
+    if (pv_len >= 2 && pv_line[0] == move) return pv_line[1];
+
+    Position next = *pos;
+    MoveState state;
+    if (!make_move(&next, &state, move, keys)) return 0;
+
+    int score, reply = 0, eval;
+    tt_probe(next.zobrist_hash, MAX_PLY, -MATE_SCORE, MATE_SCORE, &score, &reply, &eval);
+    if (!reply) return 0;
+
+    MoveList list;
+    generate_legal_moves(&next, &list, next.side_to_move, magic, keys);
+    for (int i = 0; i < list.count; i++) {
+        if (list.moves[i] == reply) return reply;
+    }
+    return 0;
+}
+
+static void print_bestmove(int move, int ponder_move) {
+    char move_str[6], ponder_str[6];
+    move_to_uci(move, move_str);
+    if (ponder_mode && ponder_move) {
+        move_to_uci(ponder_move, ponder_str);
+        printf("bestmove %s ponder %s\n", move_str, ponder_str);
+    } else {
+        printf("bestmove %s\n", move_str);
+    }
+}
+
+static void cache_mate_line(const Position* pos, const int* line, int length, const ZobristKeys* keys) {
+    Position copy = *pos;
+    MoveState state;
+    forced_mate_length = 0;
+    for (int i = 0; i < length; i++) {
+        if (!make_move(&copy, &state, line[i], keys)) break;
+        forced_mate_line[i] = line[i];
+        forced_mate_keys[i] = copy.zobrist_hash;
+        forced_mate_length = i + 1;
+    }
+    forced_mate_index = 1;
+}
+
+// Runs one go command on its own thread, so that the UCI loop can answer isready and stop meanwhile
+static void* search_thread_main(void* arg) {
+    SearchJob* job = (SearchJob*)arg;
+    Position* pos = job->pos;
+    MoveList* list = job->list;
+    const MagicData* magic = job->magic;
+    const ZobristKeys* keys = job->keys;
+
+    generate_legal_moves(pos, list, pos->side_to_move, magic, keys);
+    EvalParams params;
+    set_default_evalparams(&params);
+
+    // Without a depth limit the search runs until the clock or a stop command ends it
+    int max_depth = job->depth;
+    if (job->limits.depth > 0) max_depth = job->limits.depth;
+    else if (job->time.active || job->limits.infinite || job->limits.ponder) max_depth = MAX_PLY - 1;
+    if (max_depth > MAX_PLY - 1) max_depth = MAX_PLY - 1;
+
+    int result = 0;
+    int pv_line[MAX_PLY] = {0};
+    int pv_len = 0;
+    if (list->count > 0) {
+        result = find_best_move(pos, max_depth, &job->time, job->history, &params, magic, keys, pv_line, &pv_len);
+    }
+
+    // In infinite mode the best move may only be sent after the GUI said stop, and while pondering
+    // only after ponderhit or stop
+    while ((job->limits.infinite || atomic_load(&search_pondering)) && !atomic_load(&stop_requested)) {
+        sleep_ms(1);
+    }
+    atomic_store(&search_pondering, 0);
+
+    // The position stays as the GUI set it, the next position command brings our move along
+    if (list->count == 0 || result == 0) {
+        printf("bestmove 0000\n");
+    } else {
+        if (get_search_score() > MATE_SCORE - 1000) {
+            // Only our own mates are replayed, the whole line is kept for the moves that follow
+            cache_mate_line(pos, pv_line, pv_len, keys);
+            printf("info string Forced mate detected\n");
+        }
+        print_bestmove(result, find_ponder_move(pos, result, pv_line, pv_len, magic, keys));
+    }
+    fflush(stdout);
+    return NULL;
+}
+
+// Records the position a game move is played from; an irreversible move clears the history
+static void play_game_move(Position* pos, MoveState* state, int move, const ZobristKeys* keys) {
+    uint64_t key = pos->zobrist_hash;
+    if (!make_move(pos, state, move, keys)) return;
+
+    if (pos->halfmove_clock == 0) {
+        game_history.count = 0;
+        return;
+    }
+    if (game_history.count == MAX_GAME_HISTORY) {
+        memmove(game_history.keys, game_history.keys + 1, sizeof(uint64_t) * (MAX_GAME_HISTORY - 1));
+        game_history.count--;
+    }
+    game_history.keys[game_history.count++] = key;
+}
+
+static void wait_for_search(void) {
+    if (search_running) {
+        pthread_join(search_thread, NULL);
+        search_running = 0;
+    }
+}
+
+static void stop_search(void) {
+    atomic_store(&stop_requested, 1);
+    wait_for_search();
+}
+
+void uci_loop(Position* pos, MoveList* list, MoveState* state, int depth, const MagicData* magic, const ZobristKeys* keys) {
     char line[32767];
     printf("id name JkCheeserChess\n");
     printf("id author JkCheese\n");
     printf("option name UCI_Chess960 type check default false\n");
     printf("option name InstantMate type check default false\n");
+    printf("option name Ponder type check default false\n");
+    printf("option name Threads type spin default 1 min 1 max %d\n", MAX_THREADS);
+    printf("option name Hash type spin default %d min 1 max %d\n", TT_DEFAULT_MB, TT_MAX_MB);
+    printf("option name Move Overhead type spin default %d min 0 max %d\n", DEFAULT_MOVE_OVERHEAD, MAX_MOVE_OVERHEAD);
     fflush(stdout);
 
     while (fgets(line, sizeof(line), stdin)) {
         line[strcspn(line, "\n")] = '\0';
 
-        if (strncmp(line, "uci", 3) == 0) {
+        if (strcmp(line, "uci") == 0) {
             printf("uciok\n");
             fflush(stdout);
 
@@ -69,17 +239,45 @@ void uci_loop(Position* pos, MoveList* list, MoveState* state, int depth, const
             printf("readyok\n");
             fflush(stdout);
 
+        } else if (strncmp(line, "stop", 4) == 0) {
+            stop_search();
+
+        } else if (strncmp(line, "ponderhit", 9) == 0) {
+            // The opponent played the expected move: the same search goes on, now on our own clock
+            if (search_running && atomic_load(&search_pondering)) {
+                time_restart(&search_job.time);
+                atomic_store_explicit(&search_pondering, 0, memory_order_release);
+            }
+
         } else if (strncmp(line, "setoption", 9) == 0) {
-            if (strstr(line, "name InstantMate")) {
+            stop_search();
+            if (strstr(line, "name Ponder")) {
+                ponder_mode = strstr(line, "value true") != NULL;
+            } else if (strstr(line, "name InstantMate")) {
                 if (strstr(line, "value true")) instant_mate_mode = 1;
                 else instant_mate_mode = 0;
+            } else if (strstr(line, "name Threads")) {
+                const char* value = strstr(line, "value");
+                if (value) set_search_threads(atoi(value + 6));
+            } else if (strstr(line, "name Hash")) {
+                const char* value = strstr(line, "value");
+                if (value) tt_resize((size_t)atoi(value + 6));
+            } else if (strstr(line, "name Move Overhead")) {
+                const char* value = strstr(line, "value");
+                if (value) {
+                    move_overhead = atoi(value + 6);
+                    if (move_overhead < 0) move_overhead = 0;
+                    if (move_overhead > MAX_MOVE_OVERHEAD) move_overhead = MAX_MOVE_OVERHEAD;
+                }
             }
 
         } else if (strncmp(line, "ucinewgame", 10) == 0) {
+            stop_search();
             forced_mate_index = 0;
             forced_mate_length = 0;
 
         } else if (strncmp(line, "position", 8) == 0) {
+            stop_search();
             const char* ptr = line + 9;
             if (strncmp(ptr, "startpos", 8) == 0) {
                 init_position(pos, STARTPOS_FEN);
@@ -90,10 +288,14 @@ void uci_loop(Position* pos, MoveList* list, MoveState* state, int depth, const
                 char fen[256] = {0};
                 sscanf(ptr, "%255[^\n]", fen);
                 init_position(pos, fen);
-                pos->zobrist_hash = compute_zobrist_hash(pos, keys);
                 ptr += strlen(fen);
             }
 
+            // Hash keys for both startpos and fen, make_move() keeps them up to date from here
+            pos->zobrist_hash = compute_zobrist_hash(pos, keys);
+            pos->pawn_hash = compute_pawn_hash(pos, keys);
+            game_history.count = 0;
+
             char* moves = strstr(line, "moves");
             if (moves) {
                 moves += 6;
@@ -101,60 +303,76 @@ void uci_loop(Position* pos, MoveList* list, MoveState* state, int depth, const
                 while (sscanf(moves, "%7s", move_str) == 1) {
                     int move = parse_move(pos, move_str, magic, keys);
                     if (move) {
-                        if (!make_move(pos, state, move, keys)) {
-                            fprintf(stderr, "Illegal move: %s\n", move_str);
-                            break;
-                        }
+                        play_game_move(pos, state, move, keys);
                     }
                     moves += strlen(move_str);
                     while (*moves == ' ') moves++;
                 }
             }
 
+        } else if (strncmp(line, "bench", 5) == 0) {
+            // Same as the command line mode, run on the UCI thread
+            stop_search();
+            int bench_depth = BENCH_DEFAULT_DEPTH, threads = BENCH_DEFAULT_THREADS, hash_mb = BENCH_DEFAULT_HASH_MB;
+            sscanf(line + 5, "%d %d %d", &bench_depth, &threads, &hash_mb);
+            run_bench(bench_depth, threads, hash_mb, magic, keys);
+
+        } else if (strncmp(line, "go perft", 8) == 0) {
+            // Runs on the UCI thread: it is a movegen test, not a search, and answers in one go
+            stop_search();
+            PerftTable table;
+            int have_table = perft_table_init(&table, PERFT_HASH_DEFAULT_MB);
+            int64_t start = time_now_ms();
+            uint64_t nodes = perft_divide_uci(pos, atoi(line + 9), have_table ? &table : NULL, magic, keys);
+            int64_t elapsed = time_now_ms() - start;
+            printf("info string perft time %lld ms nps %llu\n", (long long)elapsed,
+                   (unsigned long long)(nodes * 1000 / (uint64_t)(elapsed > 0 ? elapsed : 1)));
+            fflush(stdout);
+            if (have_table) perft_table_free(&table);
+
         } else if (strncmp(line, "go", 2) == 0) {
-            if (instant_mate_mode && forced_mate_index < forced_mate_length) {
-                int move = forced_mate_line[forced_mate_index++];
-                char move_str[6];
-                move_to_uci(move, move_str);
-                printf("bestmove %s\n", move_str);
-                make_move(pos, state, move, keys);
+            stop_search();
+            SearchLimits limits;
+            parse_go(line, &limits);
+
+            // The cached mate is followed as long as the opponent keeps playing the expected replies.
+            // A ponder search must not answer before ponderhit, so it searches as usual.
+            if (instant_mate_mode && !limits.ponder && forced_mate_index + 1 < forced_mate_length &&
+                pos->zobrist_hash == forced_mate_keys[forced_mate_index]) {
+                int move = forced_mate_line[forced_mate_index + 1];
+                int reply = (forced_mate_index + 2 < forced_mate_length) ? forced_mate_line[forced_mate_index + 2] : 0;
+                forced_mate_index += 2;
+                print_bestmove(move, reply);
                 fflush(stdout);
                 continue;
             }
+            if (!limits.ponder) {
+                forced_mate_index = 0;
+                forced_mate_length = 0;
+            }
 
-            generate_legal_moves(pos, list, pos->side_to_move, magic, keys);
-            EvalParams params;
-            set_default_evalparams(&params);
-
-            if (list->count > 0) {
-                int mate_line[32] = {0};
-                int mate_len = 0;
-                int result = find_best_move(pos, depth, &params, magic, keys, mate_line, &mate_len);
-
-                if (result == 2 && mate_len > 0) {
-                    memcpy(forced_mate_line, mate_line, sizeof(int) * mate_len);
-                    forced_mate_index = 1;
-                    forced_mate_length = mate_len;
-                    char move_str[6];
-                    move_to_uci(mate_line[0], move_str);
-                    printf("info string Forced mate detected\n");
-                    printf("bestmove %s\n", move_str);
-                    make_move(pos, state, mate_line[0], keys);
-                } else if (result == 0) {
-                    printf("bestmove 0000\n");
-                } else {
-                    char move_str[6];
-                    move_to_uci(result, move_str);
-                    printf("bestmove %s\n", move_str);
-                    make_move(pos, state, result, keys);
-                }
-            } else {
+            search_job = (SearchJob){
+                .pos = pos, .list = list,
+                .magic = magic, .keys = keys, .depth = depth, .history = &game_history,
+                .limits = limits
+            };
+            init_time_manager(&search_job.time, &search_job.limits, pos->side_to_move, move_overhead);
+
+            atomic_store(&stop_requested, 0);
+            atomic_store(&search_pondering, limits.ponder);
+            if (pthread_create(&search_thread, NULL, search_thread_main, &search_job) != 0) {
+                fprintf(stderr, "Failed to start the search thread\n");
+                atomic_store(&search_pondering, 0);
                 printf("bestmove 0000\n");
+                fflush(stdout);
+                continue;
             }
-            fflush(stdout);
+            search_running = 1;
 
         } else if (strncmp(line, "quit", 4) == 0) {
             break;
         }
     }
+
+    stop_search();
 }
\ No newline at end of file
@@ -1,31 +1,248 @@
+#include "geometry.h"
 #include "zobrist.h"
-#include <stdlib.h>
-#include <time.h>
-
-static uint64_t random_u64() {
-    return ((uint64_t)rand() << 48) ^
-           ((uint64_t)rand() << 32) ^
-           ((uint64_t)rand() << 16) ^
-           ((uint64_t)rand());
-}
-
-void init_zobrist(ZobristKeys* keys) {
-    srand(20250707); // fixed seed for reproducibility
-
-    for (int p = 0; p < 12; p++)
-        for (int sq = 0; sq < 64; sq++)
-            keys->zobrist_pieces[p][sq] = random_u64();
+#include <stdio.h>
+#include <string.h>
 
-    for (int i = 0; i < 16; i++)
-        keys->zobrist_castling[i] = random_u64();
+#define CUCKOO_MAX_KICKS 1000 // Evictions per insertion before the table is declared full
 
-    for (int f = 0; f < 8; f++)
-        keys->zobrist_en_passant[f] = random_u64();
+uint64_t cuckoo_keys[CUCKOO_SIZE];
+uint16_t cuckoo_moves[CUCKOO_SIZE];
 
-    keys->zobrist_side = random_u64();
-}
+// Frozen key table, so hashes are identical on every platform and build. The keys are the output of
+// splitmix64 seeded with 0x4A6B436865657365, drawn in the order of the fields below.
+const ZobristKeys zobrist_keys = {
+    .zobrist_pieces = {
+        { // WP
+            0x44f3e4e30d6aa3b9ULL, 0x88ff65f5fa1c06a2ULL, 0x449b4c620610a108ULL, 0x60c179aa88efe0c9ULL,
+            0x4ff1cfdfb222559aULL, 0xe1e2b661dd2c0b5cULL, 0xaa5618e0f95dcd85ULL, 0xcd6e06bb220c7722ULL,
+            0x9a494a1ae2f53695ULL, 0x9eeb5ca1e52fcb41ULL, 0xd42b06812e08d4f4ULL, 0x9410e65dd5ef1cb6ULL,
+            0x32b50f1cf90f14e5ULL, 0x7d16688594d1ff1cULL, 0x701a7f5711997a88ULL, 0x42c54ae45e7134afULL,
+            0x559115e71559c9c5ULL, 0xbf759f3d56b79ee7ULL, 0x97afc38f3848c9abULL, 0xb8e12fcd497511a3ULL,
+            0x4cb859a067225951ULL, 0xaa2d2809bdf4e08dULL, 0x9cbf36fa47b0af5aULL, 0x0ccf0129c677845dULL,
+            0x830e19fe87bea7e3ULL, 0xef06572ee5d0ea0aULL, 0x8948e9177c5cbaedULL, 0xdea6845290a75827ULL,
+            0x05c73e82eb2262feULL, 0x04ea9d40d986ab0aULL, 0x2859a26ac606a086ULL, 0xeb3834ea6a55a285ULL,
+            0x674d2e6dfd588a53ULL, 0xf21275f06c30471fULL, 0x8d5b7b7a5775e816ULL, 0xcd0dab81e7cfd35cULL,
+            0x2786b7d0c1c78e14ULL, 0xd34ac72f6622ee22ULL, 0x6c79e3e51efc1f99ULL, 0xf2c11cdccf33d669ULL,
+            0xef913443bcea0f73ULL, 0xbc83e6dd368c85fcULL, 0xb1fc0d76e7d3e42aULL, 0x9758a1cb1220ddfcULL,
+            0xef46db780f9938f1ULL, 0x05235a35e642a5d0ULL, 0x0128cd163cb9ab7dULL, 0xc857481f0c689c4eULL,
+            0x93b988a9af0d05a7ULL, 0x561e2abba122f1d7ULL, 0xc3465bb073c58bcfULL, 0xfe957c92f62f07bbULL,
+            0x49603bca0733e66fULL, 0xa1203384ad307fb9ULL, 0x484eed6839607d8aULL, 0x5b600918ac92ef2fULL,
+            0xccbad5744a3a8eb4ULL, 0xd71fd44d28af17a1ULL, 0x1cbd3e10fe6bc275ULL, 0xa2eda0c7f829b02dULL,
+            0x57f865c4d9f1d688ULL, 0x67eb61c49d4ff619ULL, 0xc3848aece6d0542bULL, 0xf8e306bf279062c7ULL
+        },
+        { // WN
+            0x4e0515ca26892cd8ULL, 0xf74bb88ae7e6c941ULL, 0x0ab799316c7e7bdeULL, 0x41ed4dc06255cdf7ULL,
+            0x75b8a6f1f65012deULL, 0xa6caf59977b25edeULL, 0x4fa826c8f879f62dULL, 0x1029cd886e648baeULL,
+            0x24c7723040f3e375ULL, 0xbf89d724a30c3591ULL, 0xa4439eb1f39dc6afULL, 0x2f90fb3b876a70caULL,
+            0xe6f4d3c681f6f33cULL, 0xff6d92d4dd27900bULL, 0x875c1b5ef91c593cULL, 0x390948998b2917ecULL,
+            0x12b7f5b40dc4e77eULL, 0x20226a149cf0960dULL, 0x57625f2ddc3b75c3ULL, 0xdb2ffdac64ca5108ULL,
+            0x17984b31d566d228ULL, 0xe8f7f2c5762a5bb7ULL, 0xa372888b9dc1e4e7ULL, 0x777f6573be8bcf4aULL,
+            0xbe1df7be025591b6ULL, 0x7692941df54c1dfbULL, 0x0d496b40073662bbULL, 0x6fd86ad42328d538ULL,
+            0xc1ba5db04f44be27ULL, 0x0ab2d7456fe13ddcULL, 0x92299fc1afe6a543ULL, 0x53b1e3d9544250a2ULL,
+            0xf0c07fa4f286529bULL, 0xc8a3d3331833849aULL, 0x122ab05b6df1e159ULL, 0x7fa817f3d9279ad8ULL,
+            0xdbc6b19a2d5ed376ULL, 0x4bcf88dba0ec02e2ULL, 0x4bd692f0506788b7ULL, 0x0fb52a3d5f93c9a1ULL,
+            0x0df88cb9c6d015afULL, 0x7402f17b15beaf43ULL, 0xcb7ddc373f466e5bULL, 0xc9277e3b6ab1a277ULL,
+            0x3fb6f613bec40d1cULL, 0x9978f0606b733929ULL, 0xf65c7c39bbab71e3ULL, 0x5cade7328db54f3cULL,
+            0x5a4a8be024951cb0ULL, 0x88a6ecd114a5d805ULL, 0x70c472236faae053ULL, 0x45b1c54c2817954eULL,
+            0x06af36573a577dddULL, 0xce7e9423f52996f2ULL, 0x6da8bb7542afc254ULL, 0xc5223efd38d07282ULL,
+            0x1ee525354f0d6510ULL, 0x5369ea1a01550daeULL, 0x5350438309a094d3ULL, 0x47c1d2edc1dab6beULL,
+            0x8bc593bc94c19deeULL, 0x8411c15d896f795bULL, 0x2a77740f24ef5cf3ULL, 0xa159ed0851c6715bULL
+        },
+        { // WB
+            0x9c1c0183dd88e371ULL, 0x05e88fdfdbddcfcaULL, 0x869d0128746a8266ULL, 0x69dd45e8142f3ad8ULL,
+            0x2b3f7f6ca716af70ULL, 0x2fa55a85dd00f090ULL, 0x6d1b565b5ba46dc9ULL, 0x45ec95fce7d9eb67ULL,
+            0xeee340cbfb945e48ULL, 0x5e24a9362c222585ULL, 0xc5b7cfd1101e5ac4ULL, 0xba30830d005b783dULL,
+            0x12d19ad694b562d7ULL, 0x5eef0134f8f6f421ULL, 0x2a84e12af1abd66cULL, 0x2637bcefe1634796ULL,
+            0xc02583c5965745cfULL, 0xd27e920927577e0cULL, 0xf801bb860f3a170eULL, 0x8e841d12333c720cULL,
+            0xd2fa0c275734caa1ULL, 0x7a5853d7e1fb2552ULL, 0x0578658d7b8ddd52ULL, 0xa7e7ed57983445f2ULL,
+            0x1aeea2475ae5f428ULL, 0x4b17a7cf45d952f3ULL, 0xdd670708300e3516ULL, 0x549467b72e1ab173ULL,
+            0x11d2a91ae2a73cf0ULL, 0x342aa4d691ad2f7cULL, 0x0d138d3c4fe911dcULL, 0x7f7b965703c02a0bULL,
+            0x1c8bef55c2f572d9ULL, 0x64e3b5562264e07aULL, 0x0c6dc0b1b97b16cbULL, 0xd2a2daed5cb9bb63ULL,
+            0x7d0bab85a2fb3df1ULL, 0x0833629130402562ULL, 0x295b7da7f721b369ULL, 0x32f708e1e040f0e2ULL,
+            0x0e8308f17689d5b8ULL, 0xc0a3a99f9a4ee139ULL, 0x7d9d2eebd67f57ceULL, 0x2ec7f8b96731bc89ULL,
+            0xbacf69c9750197c4ULL, 0x500cfe9bca6fd9d0ULL, 0xaec575c300b0bf35ULL, 0x0a231865283d6775ULL,
+            0x51133dc7d72d4137ULL, 0x34083ca60061ef6dULL, 0x5078748b8d3c4c65ULL, 0x676260b9c23d488aULL,
+            0x1047a364a83b3469ULL, 0x43fc0bbec5e9a5c5ULL, 0x5bedebf1cb229a10ULL, 0xe9ac08ba64fa9bb5ULL,
+            0x77aabee699e534ffULL, 0x4cb5d24d1f8abd4aULL, 0x406c8c4e51ab9b65ULL, 0x979ed6443114ffa8ULL,
+            0xa8dd4dc8c396d1b8ULL, 0x6a0bb8cdd24104a5ULL, 0x78fb919851602018ULL, 0x37da2e1f152a4e3eULL
+        },
+        { // WR
+            0x2416a165d36f314aULL, 0xc58bdf69ca62cdb2ULL, 0x0f46492471e45013ULL, 0x9d2fd5f23a0314c2ULL,
+            0xaec257d2e0a02fc2ULL, 0x208d66bd2f854ff7ULL, 0x997b754b6f510c44ULL, 0xf1900b214fe3cbadULL,
+            0xcb7c2d798654319fULL, 0x6063fe57d9049b51ULL, 0xa275625032c14427ULL, 0x218981babfedd452ULL,
+            0x511ccfd7f5ab56dcULL, 0xeb06ce0a220147a6ULL, 0xb7ed50152842a06aULL, 0x4f584324a6e16d54ULL,
+            0x7bafcff4eaaf71f0ULL, 0x4c32f46c76aea322ULL, 0xcfb6e58795e127daULL, 0x4d5d077070e90054ULL,
+            0xfda4a491fef4ad6bULL, 0xa59add7fa96852d5ULL, 0x8a0297f87922a0aeULL, 0xb22e422d9ab65b6fULL,
+            0x05fb0eed110789e9ULL, 0x311cf72af91f54adULL, 0x9ae831bc6ae11520ULL, 0x696b4b50647d96fbULL,
+            0x984d4dee5809f283ULL, 0xede5728b34cc1f1cULL, 0x9ca22901d2490c64ULL, 0x5640c1f77333e884ULL,
+            0xcf399a9b56b70887ULL, 0xa14fb26aad62e3dfULL, 0x896a4253a225b423ULL, 0xd880e20ea4d62b7dULL,
+            0xe03b4b998be0f6f4ULL, 0x7e8252af355b6e7cULL, 0x63c905e171a273c3ULL, 0x811bb173c8d79e95ULL,
+            0xc0bf8afb570e248eULL, 0x7e947392ee1c6a17ULL, 0xd09ef446b474bbf7ULL, 0x169d9ec5c98cfac3ULL,
+            0xc1810720f4d80f59ULL, 0xde60bac7648a568dULL, 0x45c2596112f3e5b3ULL, 0x56dc2568afb00ce7ULL,
+            0x9ed2d2bca7044659ULL, 0xe7ef67c231bffc04ULL, 0x9682271e4a144cb5ULL, 0xe17a018251bd6465ULL,
+            0x7a131267d33381ffULL, 0x1b82a7cacf57584fULL, 0xc4043607e9db4401ULL, 0xc109238a422f88a1ULL,
+            0x88b305eab6340d8cULL, 0xa265c3dabadc0d73ULL, 0xf24091333d838eeeULL, 0x967d6116e503eedbULL,
+            0x88cda52ee1ce9145ULL, 0xf6bee05980c1d035ULL, 0xb34e27f94760c209ULL, 0x61d59fa78816426fULL
+        },
+        { // WQ
+            0xf3dd70d4510d250fULL, 0xfe85a8d4c74ea43cULL, 0x73c5ab95360fa5d2ULL, 0x68f429c8d938b707ULL,
+            0xa004886b21969e73ULL, 0x9e470c7619e02be6ULL, 0x6e9ffaa28ff1009eULL, 0xa6c74f20d8e1b56aULL,
+            0x6cdcaa95fb439a38ULL, 0x5ca7f45005e31a98ULL, 0x56da93e9456ac15fULL, 0x52dffb10b2d9e346ULL,
+            0x95150e4f6058e261ULL, 0x20e3e9c8e4348a10ULL, 0x1e3bc9551ab49d5fULL, 0x74a5dc756c220a8eULL,
+            0x8ce1c37a29fed9aaULL, 0x41e0c9996984e88eULL, 0x35a44d02bd2c790dULL, 0x97a72cbbef2a67b6ULL,
+            0x3050444fae9c43ebULL, 0x37df8639578a357eULL, 0x49493328684ff015ULL, 0x058a41821b918586ULL,
+            0xeb51e75810dc7c78ULL, 0x36d9b675e624e545ULL, 0xbceab903173e264fULL, 0xeeb1da9abb4d28d9ULL,
+            0x1bb698a290b195baULL, 0x10bd1d88e6369a7cULL, 0x8eebc14630a84407ULL, 0x42c7874efa3a689aULL,
+            0x1aac4942d88a661dULL, 0xe008206e81bdb7cdULL, 0xf060cc06e1c927aeULL, 0xe1c70b4388727333ULL,
+            0xf4c52265e670e7ecULL, 0xb99c08a19a7eda92ULL, 0x1a749dc2eeb529b5ULL, 0x067d0d72ecf63e93ULL,
+            0x69821dfa392a65e3ULL, 0x682bca22110633faULL, 0x402a3035328fb6f6ULL, 0xefbe50768a2d5bbaULL,
+            0xa6f61ccd17b47693ULL, 0xff319d0df67508b7ULL, 0xa0bb4893c63e44a6ULL, 0x490646bde0d37700ULL,
+            0x219203b9177af59bULL, 0x7372359a943920e5ULL, 0xc434819cf6d678afULL, 0xb1d53800096c4ab0ULL,
+            0x8e3b16005a6919d5ULL, 0x0bc8be56b45adef1ULL, 0x626f80d22a0c587aULL, 0xda6a0f9c51969887ULL,
+            0x8d8abfbc272d0b8aULL, 0xb092719e177dd64bULL, 0xa62d427ccee47702ULL, 0x884a37bda90afd27ULL,
+            0x40129dc0c54e4028ULL, 0x86ef7c5a94b0ce66ULL, 0x744fa219ad6d7bafULL, 0xd2f31b788e7fd141ULL
+        },
+        { // WK
+            0x8de0912c05bd0b3fULL, 0x6080f0accf93f4d7ULL, 0x05fc402ec0cca8aeULL, 0xd0427942c51df62bULL,
+            0x36e3166175c16ec5ULL, 0x297eac93a9d44cbeULL, 0xf0cc61ac7e981edcULL, 0x118f91c94fe705cfULL,
+            0x54cd6dcec0fe7b7eULL, 0xabec9eeecca4ece7ULL, 0xeb20f6a16fb6390dULL, 0x6b4a0cbb8db269f4ULL,
+            0x286f9c43c02fe50bULL, 0x6aea4f83bf74d021ULL, 0x76cfb9956ab928b8ULL, 0xa29ee03013607983ULL,
+            0x25b9f8f8bdd2f551ULL, 0xc492fece06567d3bULL, 0xa28bfac4c3e9f8deULL, 0xc9dd1182a207c803ULL,
+            0x9534e4ad0c826ea9ULL, 0xe94a954f8eca91a6ULL, 0x42b92c00e65dd6e5ULL, 0x08eea7a45d914de1ULL,
+            0x6c937027fafc625fULL, 0x3db5fcf302a6e6bcULL, 0xc0cecf7e139a06e3ULL, 0xf5bc8b7b5cb7ba4fULL,
+            0xe48e9da297f78cb4ULL, 0x068f88702dd3c8b4ULL, 0x38fcfb2046b13bccULL, 0x3f11d47a184b278eULL,
+            0x1345dda037c30798ULL, 0x8ac6585c05eb5db2ULL, 0x758f67f07995c760ULL, 0xb13ef2f7942b4d1cULL,
+            0x505bdb699bb3382aULL, 0x810faabb41d04ce3ULL, 0x7f858829cf13e20fULL, 0x2180691898f5ab80ULL,
+            0x151081f91719c0caULL, 0x2d9ba0389e96042cULL, 0x6c7b9fd95d346fd8ULL, 0x6cd6f0d6765cec8bULL,
+            0x59b1b887edb44869ULL, 0xbab91e094e5469a1ULL, 0xb7dc6cd11dc3a3ffULL, 0xb027781f455435e4ULL,
+            0xd24dfa273275bbd4ULL, 0xefc506e3e5a52b0aULL, 0x898d0829776e6d6cULL, 0x07daf11021ca97f8ULL,
+            0x81fa5d740fef1b4dULL, 0x2376c8265e78a583ULL, 0x4c664e87c7ca700fULL, 0x6b6d9a242ba7bc13ULL,
+            0x5d4239e650f6b878ULL, 0x484953712901cc15ULL, 0x4f010448d57fe7e9ULL, 0xa635879cf3282df9ULL,
+            0xad92205cd70285f8ULL, 0xa89a14d932b541b0ULL, 0x612eeee2c7d864faULL, 0xedf1499beda50e68ULL
+        },
+        { // BP
+            0x3413cae58eeb7627ULL, 0x4e2dd0301b060b6dULL, 0xc5c9d3d60e8ef2fdULL, 0xde28ef86fc7405c8ULL,
+            0xae1a3e3d77d82f35ULL, 0x929c4e1496a3c197ULL, 0xed9b150ea640fa1dULL, 0xd0dbfa98b2e5a2e6ULL,
+            0x932f6a9eb1801ca8ULL, 0x052c99472c472c12ULL, 0x0c9cd9a68334abfcULL, 0xbf48d5bf986ab7a0ULL,
+            0xb43d8b581b370ec2ULL, 0x9a72d541b19472abULL, 0x722ebe48cebd3cb3ULL, 0xa6f46deaceea8014ULL,
+            0x5322abde3df17179ULL, 0x4bcec0bc26916bf9ULL, 0xe447017976a57b02ULL, 0x99046bbbbacc2e24ULL,
+            0x943a1426498428f6ULL, 0xaf7a1d510beb8ea1ULL, 0xcf75beb0954d0587ULL, 0xd3a17cc64e311a7aULL,
+            0x91accbb19b4f394dULL, 0xfe9139c76ecfa025ULL, 0x0ae00d6713b8e894ULL, 0x6bdc2ceab6143be7ULL,
+            0x0373558d19f583d2ULL, 0x0ec76b03e62fd892ULL, 0x95fc281f39f5150eULL, 0xadd47fd6fdccb47cULL,
+            0xd5e1589de9c51132ULL, 0x541150c585025be0ULL, 0xf4f92f421ddfa2f0ULL, 0x7172b502b0bf901bULL,
+            0x8a3cfae343dd53a1ULL, 0xb3aa0675137043beULL, 0x96228bfb28da13dfULL, 0x15b58353415e97c3ULL,
+            0x4f811ebd465d46a7ULL, 0x367f27e6f6365d7aULL, 0xddbf14551539a2a2ULL, 0x9dce15a1d6a0a031ULL,
+            0xe3d2eddeff61f12dULL, 0xa940087d9d1f7b2cULL, 0x476b46f6ef87a557ULL, 0xd3defd59c0571f49ULL,
+            0xdd763143795c60f4ULL, 0xe04b19f055fc8401ULL, 0x8a54c778530f0972ULL, 0xf8775bdadbd3e1b8ULL,
+            0x5f329256cea638f4ULL, 0xf4fe643cd9347048ULL, 0xb10f23408db097f7ULL, 0xa2bc51b948420864ULL,
+            0xefeefae67d4529d0ULL, 0xc63fcbe5ca968127ULL, 0x920eb5e22a0cccf4ULL, 0x29ff4612df859e59ULL,
+            0xa85992ed25f05d98ULL, 0x629ac7864313577fULL, 0x0673a9683fab645eULL, 0xd63f77c7680164f3ULL
+        },
+        { // BN
+            0x02212d7580bb53a5ULL, 0xdcedb4a5a5a97cd5ULL, 0x72b52a2624f6990aULL, 0x69c18fa32aea7258ULL,
+            0x55baf17d3fc0b31cULL, 0x99306800782adb27ULL, 0x057e4ad6e4045d80ULL, 0x9e7efd1b606f672cULL,
+            0x6cf6b2a79788d23eULL, 0x600c400b4814c509ULL, 0x09b120be583d0cccULL, 0xb8f9386efcb8dc33ULL,
+            0xd82be608f1585681ULL, 0x80ce957a77ea63f5ULL, 0x969cec83d61bdf52ULL, 0x310a2e7cd4222efcULL,
+            0x8a32748510739714ULL, 0x1ad80b43fb3c4485ULL, 0x4f95c950ac600609ULL, 0x889e82d01b6ba008ULL,
+            0x840c409456d12aa3ULL, 0x22f2c6191e21e3f6ULL, 0x712d279b54a13667ULL, 0x2f9ff8aeba070d0eULL,
+            0xc9a036da0c894b79ULL, 0x392b543c7ca599bbULL, 0xff171f866f231000ULL, 0x5c70045fb752755fULL,
+            0x2a326edfd958c34aULL, 0x18a6b5b151c7d880ULL, 0xc9ed2592c1547a3aULL, 0xd8693a36f7af17b3ULL,
+            0x199ced74baf9d4b7ULL, 0x474714ad26dea367ULL, 0x0aadb2628af8ef55ULL, 0xb7a2332cbda2f4baULL,
+            0x2ca7ae6f3acd3112ULL, 0x746591c776b58933ULL, 0xed896ee9d65eba42ULL, 0xd2e9f77241cfdb19ULL,
+            0x440b4604551f6a71ULL, 0xea95bf666ab9ec11ULL, 0xbf055cd1f766cafbULL, 0x9aab383256609e38ULL,
+            0xccfe3f25ddc2243dULL, 0x4c15721bb4da8bafULL, 0x1cf7b2c23089c901ULL, 0x365b47854d984092ULL,
+            0xe81ec4a99759fd25ULL, 0x0719908717e4b218ULL, 0xd235b32f5e0af766ULL, 0xa1c2f8ff4ce6b928ULL,
+            0x448ce55e0163f64fULL, 0x1a282b3d580333e7ULL, 0xe76e169c68ac3081ULL, 0xa9511983a884f02fULL,
+            0xcc07c277ee6cc8bbULL, 0xafea7997474bbce6ULL, 0x5b06589991127e65ULL, 0x772de0b5ca51dea2ULL,
+            0xaedd85143930c0b7ULL, 0x7d1b69a8c96e565bULL, 0xffefe31f8eee7fadULL, 0xc4bb79ffb740271bULL
+        },
+        { // BB
+            0x93b92792e23b7cb2ULL, 0xa21804ac0c397c2fULL, 0xeb5ab099721f85fdULL, 0xb8723853421add44ULL,
+            0x78585a777019132dULL, 0x66b3894ce8d2a601ULL, 0x534911228998bc73ULL, 0xb149c30e064f2e5aULL,
+            0x8d4a793e905b3a8cULL, 0x64c1cfd4f86dd5fcULL, 0xf185930f0641bea3ULL, 0x1c25455da20b3b02ULL,
+            0x840f721b3425818aULL, 0xc10cac491a0d4219ULL, 0x93ad929dd4c79fb9ULL, 0x421e798540c817fbULL,
+            0x3377d6ba970026b8ULL, 0x54b242487c10ac7bULL, 0x7ba52c06a6df0915ULL, 0xea5383b555768c04ULL,
+            0x7116844f61ea91e4ULL, 0x428999c0dfef7a12ULL, 0x895a13c612ccab45ULL, 0xe324fe121743f49dULL,
+            0xd3d3cd50bf0ed44fULL, 0x8172628ed56e658cULL, 0x3cc4380670fbbf9dULL, 0xb7cc37a96214d4eeULL,
+            0xad551a8e94ff4793ULL, 0x0ebb86e1b49df8cfULL, 0xc271de17127b6c98ULL, 0x0976372f04e0817dULL,
+            0x33b68163ea978369ULL, 0x76e54f2307d76ffcULL, 0x3e324f8cb101920dULL, 0x1cfc7d85d5820449ULL,
+            0x38c242094b37c447ULL, 0x97faa4a450f8287fULL, 0xd074e393000853a3ULL, 0xd431a13aa0fc00caULL,
+            0xa5e6503c87a6ad95ULL, 0xde69d350a195f9ceULL, 0x22919849c17bea00ULL, 0x2e4e2aeb2da0a47dULL,
+            0xfe08ac5347797357ULL, 0x2c930fbaed91a292ULL, 0xfbaf5958eaff7533ULL, 0xcf5fa3eec65eed01ULL,
+            0xaca89fc0176423cfULL, 0x61c12634479ab47fULL, 0x0911f2915df0e27bULL, 0xe0f6bfe67e857daaULL,
+            0xcaa44561dd5ca21cULL, 0x44062276c5f7f1faULL, 0x18a3606d20d475d0ULL, 0x911313885c8c1767ULL,
+            0x934d7595c63500ecULL, 0x3ca4864e4e4768a1ULL, 0x0a964373b9de6971ULL, 0x944f01f89f10406aULL,
+            0xd8ffe25095e7692dULL, 0x3f608142817419e0ULL, 0xe8d2cb41b06c8624ULL, 0x1b76d4e07856c213ULL
+        },
+        { // BR
+            0xb035fb851f1516beULL, 0xa23875ca9c075f6fULL, 0x7ef5bbdbaff63905ULL, 0x9cf74ba8b10485d3ULL,
+            0xc5705ce9281ce667ULL, 0x3e4255d1879132c0ULL, 0xedde5972cbb68293ULL, 0xb60c3ff9724dcb9cULL,
+            0xb319bad012be608cULL, 0x02da215022425f1eULL, 0xb2ba6fa87bbac722ULL, 0xb30b64a684e71915ULL,
+            0x754fc99c0603897cULL, 0x77ee2263f55f2afdULL, 0xa1edb898da2ae361ULL, 0x995b090fc901f55fULL,
+            0x04b00ce5ebc86dbbULL, 0xcc2024089d455a4cULL, 0xff4a58d266b8ae0bULL, 0x35c370eeb99c7070ULL,
+            0x7703de3a1fe2b4c5ULL, 0x27e9d1cf877b959eULL, 0xb2a32a6a21937882ULL, 0x1e9cfb72e59c0ab1ULL,
+            0xd4a0bc2811f76323ULL, 0xe99cc4477623f498ULL, 0x33b52fccb00e4fdfULL, 0xd3918dc8bf3d24a3ULL,
+            0xd0a518b7d5c85dfeULL, 0x9b56b779fe15e5fbULL, 0xda06e47b11286910ULL, 0x604bff3431aeb57cULL,
+            0x7a6e6e88a6edf249ULL, 0xa40540e211d65e90ULL, 0xf7b1b8fea36e9e51ULL, 0x10bb2f52509bf402ULL,
+            0x4d18a2f053dc35c7ULL, 0xe340eab9d600d9f2ULL, 0xdb613ce2424e4d41ULL, 0xa117e57c5d0c80bfULL,
+            0x5d3d0922a12a501eULL, 0xa016ec5fed740201ULL, 0xa6c90d64cb19fc65ULL, 0xda9b37937d4c3189ULL,
+            0x6906d879ceccd379ULL, 0xa09dfa39f22a772fULL, 0x9aa345e1c40606d6ULL, 0xe2c69da66cd5e1beULL,
+            0xdb6a87d1da5a04f9ULL, 0x357b8e89f6c3f662ULL, 0x2ea36b2104097321ULL, 0x8e339e3a82397afdULL,
+            0x9f1b4bfac4817ffcULL, 0xed32ed10d3032ebcULL, 0xd682b6b55521cadaULL, 0xc7a6080aba4aca8eULL,
+            0xdc80f3553a99287cULL, 0x6e5af41264328b7eULL, 0xaecd70165e942a2fULL, 0xb8a3d344bc042b6bULL,
+            0x90262ecb8e335e48ULL, 0x0bd9f62a05a8366bULL, 0xb451c99a8e0416caULL, 0x929b18d4d4eeaac6ULL
+        },
+        { // BQ
+            0xecfaa50e0151fa9cULL, 0xeef941c3a71ea075ULL, 0x84aeccdfe7e6589aULL, 0x7694d22949bb5271ULL,
+            0x3cac8946bc0cf9ecULL, 0x12ab3fb4bd5ec3c9ULL, 0xee574ecbf70ed902ULL, 0x793e002116dd85d6ULL,
+            0x24c2a6c2b73c7f88ULL, 0x228c09e28216e2f1ULL, 0x6da93a37013ff617ULL, 0xca15cbb348e2b4feULL,
+            0x0bd7af1e97e93589ULL, 0x5320c7fbdcc4464aULL, 0x8e3f77aa8b949973ULL, 0xf8841dc9357ee2f4ULL,
+            0x6ae8197ffb16893cULL, 0x315da0fc19c609c1ULL, 0x729cb91e5d7b470cULL, 0x0112fd0f4450508dULL,
+            0x163d13687226bfc3ULL, 0xff9fa33cd8215dbbULL, 0xbf2ce148f0695bc7ULL, 0x21f513cc513c5e9cULL,
+            0x821acb739f9a3bf4ULL, 0x88628351b2fc80c9ULL, 0xcd0642766b2c23bcULL, 0xe4873f7a68535445ULL,
+            0x955c8395df44e847ULL, 0x4fe6e3ae950f93d7ULL, 0xe716f490cc753224ULL, 0xc92cc70347bf10a1ULL,
+            0x47d5c780287ba0c7ULL, 0x11bfcc60f43caf86ULL, 0xec684821cd0f49e1ULL, 0xd5691977cf02ddf8ULL,
+            0x60daa9dd809376d8ULL, 0x0a168ff8908301a3ULL, 0x78656153b617a82fULL, 0x0d755b0e2fc6748eULL,
+            0xdbf50798837077d5ULL, 0x14c464cbb790a7ecULL, 0x8d4ff58740e19069ULL, 0xe20c1cfd7947ab54ULL,
+            0xac9cb58375364ac0ULL, 0x67e05c66aa87cdd0ULL, 0x685efabaf2adf425ULL, 0xb3accdca5a35f964ULL,
+            0xe3f4749cca0abd77ULL, 0xc04372767e103d7cULL, 0xad760969fc74a4d2ULL, 0x21aea12f223bf873ULL,
+            0xb46b245f027c6d7aULL, 0x9e04c22c4d4daa50ULL, 0x206f0a50eb66e13bULL, 0x5b95e6a0c8522e64ULL,
+            0x2bb4a9417747696cULL, 0xf282daca4dc4b8fbULL, 0xb6011172cea12f79ULL, 0x8ef5d65fcdd3f820ULL,
+            0x8ed294050d117c9dULL, 0x2ec06828a9589ddcULL, 0xed50beff71c84584ULL, 0xb15aee2957367d8fULL
+        },
+        { // BK
+            0xfd4f05542d43d289ULL, 0xb0a3568a87733ee9ULL, 0x2f5823db01ece553ULL, 0xb380b013724081cbULL,
+            0xb868c8b501a0c631ULL, 0xe8f0a49fb04a4c78ULL, 0x435678d5dcc48dafULL, 0xf77fa884a1212cb9ULL,
+            0xa8094f0213000e3eULL, 0x8f6681c065486cb1ULL, 0x6cc5c4a0d3ffa98bULL, 0xc43dedd6bd4352cbULL,
+            0x0ef8b2e9e9c21a88ULL, 0x0aa0267af734f53bULL, 0xf514e593d7126c95ULL, 0x3daa28636a511c55ULL,
+            0x8af9d161571e0b58ULL, 0xf171144445a874f1ULL, 0x774df86c57009563ULL, 0xf5cf29566c54e06cULL,
+            0x3b4fd6f11e108b30ULL, 0x95e7a220f3d9726cULL, 0xf81179e524fd53d4ULL, 0x53db774b0fa03219ULL,
+            0xd964c07aabebf33dULL, 0x88011fed99266133ULL, 0x5559d665ff4cbe32ULL, 0xf8957b91af06d251ULL,
+            0x11c265d47b936af2ULL, 0xda219d7fb5637748ULL, 0x93b528ec7f9f635bULL, 0xe37f10dc59a8e396ULL,
+            0x8aa7691c12a0a438ULL, 0x2701d1825893bc1bULL, 0x5de7c5fdc683e897ULL, 0x555514203ad25679ULL,
+            0x566bf8337cde82b6ULL, 0xe0786b7670f382c5ULL, 0x0b1cefec72ba15bfULL, 0x2d550a3b783b65f2ULL,
+            0x0d9dcc1d281e94f9ULL, 0xdd87dbe414f3d2ebULL, 0x9e3c424561c6879bULL, 0x47981a1b37f89b61ULL,
+            0x6695e3e0296d0308ULL, 0xbf4c4aa22d1926fcULL, 0x3114b58776ef009eULL, 0x5dcb12b8c87b9d59ULL,
+            0x2df719525df366deULL, 0x93b76fcb332b6dc4ULL, 0x764e2ea7c3f0995fULL, 0xfe527527e0554817ULL,
+            0x7f3cb9b463d81c9dULL, 0x1aba6c7872645966ULL, 0x666a17a9d86e9049ULL, 0xb9927a1c2e9f5e91ULL,
+            0x39beb09b2d0253d3ULL, 0xdec24f6e576b8a53ULL, 0x94a66a33cf9b877fULL, 0x474a9677859e595cULL,
+            0x13740d465613a27dULL, 0xff3b2e718723da1fULL, 0xfdabadb8929b800cULL, 0x873bc0d2cbd703feULL
+        }
+    },
+    .zobrist_side = 0xead2918bf05a6ceeULL,
+    .zobrist_castling = {
+        0xd65ad62a47bfb271ULL, 0x67d073646e12c339ULL, 0xbc9cf94b68e1bb98ULL, 0xdc96c336e5ce4eb8ULL,
+        0xea333065f128b225ULL, 0x7b9790e8ca0fc6dfULL, 0xef9a3c4585e314e7ULL, 0x896ea09d9d9d76fbULL,
+        0xd73316a1168e9691ULL, 0x11ffaa73b5506deeULL, 0xcc128f8a7c183c94ULL, 0x158e1303b562f66aULL,
+        0x3c800a2d99889479ULL, 0xeabf086dc7fdf7aaULL, 0xf4c1e43d74d7b654ULL, 0x279f65a78c1d2ee9ULL
+    },
+    .zobrist_en_passant = {
+        0xf935e67a04ae7b2aULL, 0x860c63bfcf3bbd4fULL, 0xfda83c95bc9dae83ULL, 0x4e96eb8b3da94107ULL,
+        0xdcac4a98e12a6e50ULL, 0x96b30fd9f204cd9bULL, 0xd8311fcf48ad88fdULL, 0x1109ef58a1bd23afULL
+    }
+};
 
-uint64_t compute_zobrist_hash(const Position* pos, ZobristKeys* keys) {
+uint64_t compute_zobrist_hash(const Position* pos, const ZobristKeys* keys) {
     uint64_t hash = 0;
 
     for (int p = 0; p < 12; p++) {
@@ -46,4 +263,80 @@ uint64_t compute_zobrist_hash(const Position* pos, ZobristKeys* keys) {
         hash ^= keys->zobrist_side;
 
     return hash;
-}
\ No newline at end of file
+}
+
+// Same piece keys as the full hash, restricted to the pawns of both sides
+uint64_t compute_pawn_hash(const Position* pos, const ZobristKeys* keys) {
+    uint64_t hash = 0;
+
+    static const int pawn_pieces[2] = { WP, BP };
+
+    for (int i = 0; i < 2; i++) {
+        int p = pawn_pieces[i];
+        Bitboard bb = pos->pieces[p];
+        while (bb) {
+            int sq = __builtin_ctzll(bb);
+            hash ^= keys->zobrist_pieces[p][sq];
+            bb &= bb - 1;
+        }
+    }
+
+    return hash;
+}
+
+// Whether a piece of the given type on an empty board moves between the two squares
+static int reaches_on_empty_board(int type, int s1, int s2) {
+    int same_line = (s1 % 8 == s2 % 8) || (s1 / 8 == s2 / 8);
+    switch (type) {
+        case N: return (knight_attack_table[s1] >> s2) & 1;
+        case K: return (king_attack_table[s1] >> s2) & 1;
+        case B: return line_table[s1][s2] && !same_line;
+        case R: return line_table[s1][s2] && same_line;
+        case Q: return line_table[s1][s2] != 0;
+        default: return 0;
+    }
+}
+
+// Fills the cuckoo tables; needs the geometry tables. Returns the number of moves stored (3668),
+// or -1 if an insertion does not find a free slot.
+int init_cuckoo(const ZobristKeys* keys) {
+    memset(cuckoo_keys, 0, sizeof(cuckoo_keys));
+    memset(cuckoo_moves, 0, sizeof(cuckoo_moves));
+
+    int count = 0;
+    for (int piece = 0; piece < 12; piece++) {
+        int type = piece % 6;
+        if (type == P) continue;
+
+        for (int s1 = 0; s1 < 64; s1++) {
+            for (int s2 = s1 + 1; s2 < 64; s2++) {
+                if (!reaches_on_empty_board(type, s1, s2)) continue;
+
+                // Both directions of a move share the key, so each pair of squares is stored once
+                uint16_t move = (uint16_t)((s1 << 6) | s2);
+                uint64_t key = keys->zobrist_pieces[piece][s1] ^ keys->zobrist_pieces[piece][s2] ^ keys->zobrist_side;
+
+                // Cuckoo insertion: take the slot and move its previous occupant to its other slot
+                int slot = CUCKOO_H1(key);
+                int kicks = 0;
+                while (1) {
+                    uint64_t evicted_key = cuckoo_keys[slot];
+                    uint16_t evicted_move = cuckoo_moves[slot];
+                    cuckoo_keys[slot] = key;
+                    cuckoo_moves[slot] = move;
+                    if (evicted_move == 0) break;
+
+                    if (++kicks > CUCKOO_MAX_KICKS) {
+                        fprintf(stderr, "Cuckoo table full\n");
+                        return -1;
+                    }
+                    key = evicted_key;
+                    move = evicted_move;
+                    slot = (slot == CUCKOO_H1(key)) ? CUCKOO_H2(key) : CUCKOO_H1(key);
+                }
+                count++;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,53 @@
+// Build-time generator for the slider attack tables. Prints a C file defining magic_data with every
+// table filled in, which the Makefile compiles into the engine as read-only data.
+
+#include "magic.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void print_bitboards(const char* name, const Bitboard* values, int count) {
+    printf("    .%s = {", name);
+    for (int i = 0; i < count; i++) {
+        if (i % 4 == 0) printf("\n       ");
+        printf(" 0x%016llxULL,", (unsigned long long)values[i]);
+    }
+    printf("\n    },\n");
+}
+
+static void print_uints(const char* name, const uint32_t* values, int count) {
+    printf("    .%s = {", name);
+    for (int i = 0; i < count; i++) {
+        if (i % 8 == 0) printf("\n       ");
+        printf(" %lu,", (unsigned long)values[i]);
+    }
+    printf("\n    },\n");
+}
+
+int main(void) {
+    MagicData* magic = calloc(1, sizeof(MagicData));
+    if (!magic) {
+        fprintf(stderr, "Failed to allocate MagicData\n");
+        return 1;
+    }
+    build_magic_tables(magic);
+
+    printf("// Generated by tools/gen_magic_tables.c, do not edit\n\n");
+    printf("#include \"magic.h\"\n\n");
+    printf("const MagicData magic_data = {\n");
+    print_bitboards("rook_magics", magic->rook_magics, 64);
+    print_bitboards("bishop_magics", magic->bishop_magics, 64);
+    print_uints("rook_shifts", magic->rook_shifts, 64);
+    print_uints("bishop_shifts", magic->bishop_shifts, 64);
+    print_bitboards("rook_masks", magic->rook_masks, 64);
+    print_bitboards("bishop_masks", magic->bishop_masks, 64);
+    print_uints("rook_offsets", magic->rook_offsets, 64);
+    print_uints("bishop_offsets", magic->bishop_offsets, 64);
+    print_bitboards("rook_attack_table", magic->rook_attack_table, ROOK_TABLE_ENTRIES);
+    print_bitboards("bishop_attack_table", magic->bishop_attack_table, BISHOP_TABLE_ENTRIES);
+    print_bitboards("rook_pext_table", magic->rook_pext_table, ROOK_TABLE_ENTRIES);
+    print_bitboards("bishop_pext_table", magic->bishop_pext_table, BISHOP_TABLE_ENTRIES);
+    printf("};\n");
+
+    free(magic);
+    return 0;
+}